@@ -0,0 +1,68 @@
+#include <array>
+#include <iostream>
+#include "allocations.h"
+#include "cpu.h"
+
+namespace {
+    // Steps the program and attributes operator new calls after the warm-up to the instruction that made them
+    int count_allocations(CPUEmulator &app, const RunOptions &options, uint64_t warmup) {
+        std::array<uint64_t, command_count> executed{};
+        std::array<uint64_t, command_count> allocations{};
+        uint64_t steps = 0;
+        Trap trap;
+        app.start(options);
+        while (app.running()) {
+            auto command = static_cast<size_t>(app.program()[app.line()].command);
+            auto before = Allocations::count();
+            trap = app.step();
+            if (steps++ >= warmup) {
+                executed[command]++;
+                allocations[command] += Allocations::count() - before;
+            }
+            if (trap.kind != eTrap::Ok) {
+                break;
+            }
+        }
+        if (trap.fault()) {
+            CPUEmulator::report(trap);
+        }
+        uint64_t total = 0;
+        uint64_t measured = 0;
+        for (size_t i = 0; i < command_count; i++) {
+            total += allocations[i];
+            measured += executed[i];
+        }
+        std::cerr << "allocations: " << total << " in " << measured << " instructions after " << warmup
+                  << " warm-up instructions (" << (measured > 0 ? static_cast<double>(total) / measured : 0.0)
+                  << " per instruction)" << std::endl;
+        for (size_t i = 0; i < command_count; i++) {
+            if (allocations[i] > 0) {
+                std::cerr << "allocations: " << command_name.at(static_cast<eCommands>(i)) << ' ' << allocations[i]
+                          << " in " << executed[i] << std::endl;
+            }
+        }
+        return total == 0 ? 0 : 1;
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: AllocationBench <binary> [--warmup=N] [--workers=N]" << std::endl;
+        return 1;
+    }
+    RunOptions options;
+    uint64_t warmup = 1000;
+    for (int i = 2; i < argc; i++) {
+        std::string option = argv[i];
+        if (option.starts_with("--warmup=")) {
+            warmup = std::stoull(option.substr(option.find('=') + 1));
+        } else if (option.starts_with("--workers=")) {
+            options.workers = std::stoi(option.substr(option.find('=') + 1));
+        } else {
+            std::cerr << "Unknown option \"" << option << "\"" << std::endl;
+            return 1;
+        }
+    }
+    CPUEmulator app(argv[1]);
+    return count_allocations(app, options, warmup);
+}
@@ -0,0 +1,101 @@
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include "allocations.h"
+
+// Linking this library replaces the global allocation functions with counting ones
+
+namespace {
+    thread_local uint64_t allocations = 0;
+
+    void *allocate(std::size_t size) {
+        allocations++;
+        return std::malloc(std::max<std::size_t>(size, 1));
+    }
+
+    void *allocate(std::size_t size, std::align_val_t alignment) {
+        allocations++;
+        auto align = static_cast<std::size_t>(alignment);
+        size = std::max<std::size_t>(size, 1);
+        return std::aligned_alloc(align, (size + align - 1) / align * align);
+    }
+
+    // Retries through the new handler like the standard allocation functions do
+    template<class Allocate>
+    void *allocate_or_throw(Allocate allocate) {
+        while (true) {
+            if (auto *pointer = allocate()) {
+                return pointer;
+            }
+            auto handler = std::get_new_handler();
+            if (handler == nullptr) {
+                throw std::bad_alloc();
+            }
+            handler();
+        }
+    }
+}
+
+uint64_t Allocations::count() {
+    return allocations;
+}
+
+void *operator new(std::size_t size) {
+    return allocate_or_throw([size] { return allocate(size); });
+}
+
+void *operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    try {
+        return operator new(size);
+    } catch (std::bad_alloc &) {
+        return nullptr;
+    }
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &tag) noexcept {
+    return operator new(size, tag);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+    return allocate_or_throw([size, alignment] { return allocate(size, alignment); });
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void operator delete(void *pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t, std::align_val_t) noexcept {
+    std::free(pointer);
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstdint>
+
+class Allocations {
+public:
+    [[nodiscard]] static uint64_t count();
+};
@@ -0,0 +1,103 @@
+#include "assembler.h"
+#include "exc.h"
+
+void Assembler::run(const std::string &source_name, std::string file_name) {
+    std::ifstream source(source_name, std::ios::in);
+    if (not source.is_open()) {
+        throw std::runtime_error("File is closed");
+    }
+    file_name += ".emu";
+    file_.open(file_name, std::ios::binary | std::ios::out);
+    if (not file_.is_open()) {
+        throw std::runtime_error("Can not create file \"" + file_name + "\"");
+    }
+    if (debug_) {
+        lines_.reset(std::tmpfile());
+        if (not lines_) {
+            throw std::runtime_error("Can not create temporary file");
+        }
+    }
+    pc_ = 0;
+    symbols_.clear();
+
+    file_ << binary_magic;
+    auto code = begin_section(file_, eSection::Code);
+    std::string line;
+    std::string command;
+    std::string param;
+    int line_number = 1;
+    while (std::getline(source, line)) {
+        int column = Parser::split(line, line_number, command, param);
+        emit(command, param, line_number++, column);
+    }
+    end_section(file_, code);
+
+    auto symbols = begin_section(file_, eSection::Symbols);
+    for (auto &[name, pc]: symbols_) {
+        int32_t address = pc;
+        file_.write(reinterpret_cast<const char *>(&address), sizeof(address));
+        file_ << name << '\0';
+    }
+    end_section(file_, symbols);
+
+    if (lines_) {
+        auto debug = begin_section(file_, eSection::Debug);
+        std::rewind(lines_.get());
+        char buffer[1 << 16];
+        size_t count;
+        while ((count = std::fread(buffer, 1, sizeof(buffer), lines_.get())) > 0) {
+            file_.write(buffer, static_cast<std::streamsize>(count));
+        }
+        end_section(file_, debug);
+        lines_.reset();
+    }
+
+    auto hints = begin_section(file_, eSection::Hints);
+    StackHints unknown;
+    file_.write(reinterpret_cast<const char *>(&unknown), sizeof(unknown));
+    end_section(file_, hints);
+    file_.close();
+}
+
+void Assembler::emit(const std::string &command, const std::string &param, int line, int column) {
+    if (command == "BLANK") {
+        return;
+    }
+    if (not command_by_name.contains(command)) {
+        throw InvalidArgumentException("Unknown command \"" + command + "\"", line);
+    }
+    auto &instance = command_by_name.at(command);
+    try {
+        instance.configure(param, pc_);
+    } catch (InvalidArgumentException &e) {
+        throw InvalidArgumentException(e.what(), line);
+    } catch (UniqueException &e) {
+        throw UniqueException(e.what(), line);
+    }
+    if (instance.name() == eCommands::Label) {
+        symbols_.emplace_back(param, pc_);
+        return;
+    }
+    file_ << static_cast<uint8_t>(instance.name()) << param << '\0';
+    if (lines_) {
+        DebugLine entry{line, column, static_cast<int32_t>(symbols_.size()) - 1};
+        std::fwrite(&entry, sizeof(entry), 1, lines_.get());
+    }
+    pc_++;
+}
+
+std::streampos Assembler::begin_section(std::ostream &file, eSection section) {
+    uint32_t size = 0;
+    file << static_cast<uint8_t>(section);
+    auto position = file.tellp();
+    file.write(reinterpret_cast<const char *>(&size), sizeof(size));
+    return position;
+}
+
+void Assembler::end_section(std::ostream &file, std::streampos position) {
+    auto end = file.tellp();
+    auto size = static_cast<uint32_t>(end - position - static_cast<std::streamoff>(sizeof(uint32_t)));
+    file.seekp(position);
+    file.write(reinterpret_cast<const char *>(&size), sizeof(size));
+    file.seekp(end);
+}
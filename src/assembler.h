@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdio>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "parser.h"
+
+class Assembler {
+public:
+    explicit Assembler(bool debug = true) : debug_(debug) {}
+
+    void run(const std::string &source_name, std::string file_name);
+
+    [[nodiscard]] int size() const { return pc_; }
+
+private:
+    void emit(const std::string &command, const std::string &param, int line, int column);
+
+    static std::streampos begin_section(std::ostream &, eSection);
+
+    static void end_section(std::ostream &, std::streampos);
+
+    bool debug_;
+    int pc_ = 0;
+    std::ofstream file_;
+    std::unique_ptr<FILE, int (*)(FILE *)> lines_{nullptr, fclose};
+    std::vector<std::pair<std::string, int>> symbols_;
+};
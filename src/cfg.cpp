@@ -0,0 +1,468 @@
+#include <algorithm>
+#include <optional>
+#include <queue>
+#include <set>
+#include <unordered_map>
+#include "cfg.h"
+
+namespace {
+    struct Frame {
+        int peak = 0;
+        int net = 0;
+        int calls = 0;
+    };
+
+    int stack_effect(eCommands command) {
+        switch (command) {
+            case eCommands::Push:
+            case eCommands::PushR:
+            case eCommands::In:
+            case eCommands::Recv:
+            case eCommands::LoadR:
+                return 1;
+            case eCommands::Pop:
+            case eCommands::PopR:
+            case eCommands::Out:
+            case eCommands::Send:
+            case eCommands::Add:
+            case eCommands::Sub:
+            case eCommands::Mul:
+            case eCommands::Div:
+            case eCommands::StoreR:
+            case eCommands::MemSum:
+                return -1;
+            case eCommands::Store:
+                return -2;
+            case eCommands::MemCpy:
+            case eCommands::MemSet:
+                return -3;
+            default:
+                return 0;
+        }
+    }
+
+    // Summaries recurse into callees, deeper call chains are left unanalysed rather than overflowing the stack
+    constexpr int max_nesting = 1024;
+
+    std::optional<Frame> frame_of(const std::vector<Statement> &program, const ControlFlowGraph &cfg, int entry,
+                                  std::map<int, std::optional<Frame>> &memo, int nesting = 0) {
+        if (auto it = memo.find(entry); it != memo.end()) {
+            return it->second;
+        }
+        if (nesting > max_nesting) {
+            return std::nullopt;
+        }
+        memo[entry] = std::nullopt;
+        // Sized by the subroutine rather than the program, so deep call chains stay linear
+        std::unordered_map<int, int> depth;
+        std::vector<int> queue;
+        auto visit = [&](int index, int value) {
+            if (index < 0 || index >= program.size()) {
+                return true;
+            }
+            if (auto [it, inserted] = depth.try_emplace(index, value); not inserted) {
+                return it->second == value;
+            }
+            queue.push_back(index);
+            return true;
+        };
+
+        Frame frame;
+        std::optional<int> exit;
+        visit(entry, 0);
+        while (not queue.empty()) {
+            int i = queue.back();
+            queue.pop_back();
+            auto &statement = program[i];
+            if (statement.command == eCommands::Join) {
+                return std::nullopt;
+            }
+            int before = depth.at(i);
+            int after = before + stack_effect(statement.command);
+            int target = ControlFlowGraph::is_jump(statement.command) ? cfg.label_index(statement.param) : -1;
+            frame.peak = std::max(frame.peak, after);
+            bool consistent = true;
+            if (statement.command == eCommands::Ret) {
+                consistent = not exit || *exit == before;
+                exit = before;
+            } else if (statement.command == eCommands::Call && target != -1) {
+                auto callee = frame_of(program, cfg, target, memo, nesting + 1);
+                if (not callee) {
+                    return std::nullopt;
+                }
+                frame.peak = std::max(frame.peak, before + callee->peak);
+                frame.calls = std::max(frame.calls, callee->calls + 1);
+                consistent = visit(i + 1, before + callee->net);
+            } else if (statement.command == eCommands::Jump) {
+                consistent = visit(target, after);
+            } else if (ControlFlowGraph::is_conditional(statement.command)) {
+                consistent = visit(target, after) && visit(i + 1, after);
+            } else if (statement.command != eCommands::End && statement.command != eCommands::Call) {
+                consistent = visit(i + 1, after);
+            }
+            if (not consistent) {
+                return std::nullopt;
+            }
+        }
+        frame.net = exit.value_or(0);
+        return memo[entry] = frame;
+    }
+
+    struct Summary {
+        int floor = 0;
+        int net = 0;
+        uint32_t uses = 0;
+        uint32_t may_def = 0;
+        uint32_t must_def = 0;
+    };
+
+    int stack_reads(eCommands command) {
+        switch (command) {
+            case eCommands::Pop:
+            case eCommands::PopR:
+            case eCommands::Out:
+            case eCommands::Send:
+            case eCommands::Load:
+            case eCommands::StoreR:
+                return 1;
+            case eCommands::Add:
+            case eCommands::Sub:
+            case eCommands::Mul:
+            case eCommands::Div:
+            case eCommands::Store:
+            case eCommands::MemSum:
+                return 2;
+            case eCommands::MemCpy:
+            case eCommands::MemSet:
+                return 3;
+            default:
+                return ControlFlowGraph::is_conditional(command) ? 2 : 0;
+        }
+    }
+
+    uint32_t register_mask(const std::string &name) {
+        int index = RegisterType::index(name);
+        return index == -1 ? 0 : 1u << index;
+    }
+
+    std::optional<Summary> summary_of(const std::vector<Statement> &program, const ControlFlowGraph &cfg, int entry,
+                                      std::map<int, std::optional<Summary>> &memo, int nesting = 0) {
+        if (auto it = memo.find(entry); it != memo.end()) {
+            return it->second;
+        }
+        if (nesting > max_nesting) {
+            return std::nullopt;
+        }
+        memo[entry] = std::nullopt;
+        std::unordered_map<int, int> depth;
+        std::vector<int> queue;
+        std::vector<int> region;
+        std::map<int, Summary> callees;
+        auto visit = [&](int index, int value) {
+            if (index < 0 || index >= program.size()) {
+                return false;
+            }
+            if (auto [it, inserted] = depth.try_emplace(index, value); not inserted) {
+                return it->second == value;
+            }
+            queue.push_back(index);
+            region.push_back(index);
+            return true;
+        };
+        auto successors = [&](int i) -> std::vector<int> {
+            auto command = program[i].command;
+            int target = ControlFlowGraph::is_jump(command) ? cfg.label_index(program[i].param) : -1;
+            if (command == eCommands::Ret) {
+                return {};
+            }
+            if (command == eCommands::Jump) {
+                return {target};
+            }
+            if (ControlFlowGraph::is_conditional(command)) {
+                return {target, i + 1};
+            }
+            return {i + 1};
+        };
+
+        Summary summary;
+        std::optional<int> exit;
+        visit(entry, 0);
+        while (not queue.empty()) {
+            int i = queue.back();
+            queue.pop_back();
+            auto &statement = program[i];
+            auto command = statement.command;
+            if (command == eCommands::In || command == eCommands::Out || command == eCommands::Begin ||
+                command == eCommands::End || command == eCommands::Break || command == eCommands::Send ||
+                command == eCommands::Recv || command == eCommands::Spawn || command == eCommands::Join ||
+                ControlFlowGraph::is_memory(command)) {
+                return std::nullopt;
+            }
+            int target = ControlFlowGraph::is_jump(command) ? cfg.label_index(statement.param) : -1;
+            if (ControlFlowGraph::is_jump(command) && target == -1) {
+                return std::nullopt;
+            }
+            int before = depth.at(i);
+            summary.floor = std::min(summary.floor, before - stack_reads(command));
+            int after = before + stack_effect(command);
+            if (command == eCommands::Ret) {
+                if (exit && *exit != before) {
+                    return std::nullopt;
+                }
+                exit = before;
+                continue;
+            }
+            if (command == eCommands::Call) {
+                auto callee = summary_of(program, cfg, target, memo, nesting + 1);
+                if (not callee) {
+                    return std::nullopt;
+                }
+                callees[i] = *callee;
+                summary.floor = std::min(summary.floor, before + callee->floor);
+                after = before + callee->net;
+            }
+            for (int next: successors(i)) {
+                if (not visit(next, after)) {
+                    return std::nullopt;
+                }
+            }
+        }
+        if (not exit) {
+            return std::nullopt;
+        }
+        summary.net = *exit;
+
+        auto uses = [&](int i) {
+            if (program[i].command == eCommands::PushR) {
+                return register_mask(program[i].param);
+            }
+            return program[i].command == eCommands::Call ? callees[i].uses : 0u;
+        };
+        auto defs = [&](int i) {
+            if (program[i].command == eCommands::PopR) {
+                return register_mask(program[i].param);
+            }
+            return program[i].command == eCommands::Call ? callees[i].must_def : 0u;
+        };
+        uint32_t all = (1u << RegisterType::available.size()) - 1;
+        std::unordered_map<int, uint32_t> live;
+        std::unordered_map<int, uint32_t> must;
+        for (int i: region) {
+            live[i] = 0;
+            must[i] = all;
+        }
+        must[entry] = 0;
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (auto i = region.rbegin(); i != region.rend(); i++) {
+                uint32_t out = 0;
+                for (int next: successors(*i)) {
+                    out |= live[next];
+                }
+                uint32_t in = uses(*i) | (out & ~defs(*i));
+                changed |= in != live[*i];
+                live[*i] = in;
+            }
+            for (int i: region) {
+                for (int next: successors(i)) {
+                    uint32_t in = must[next] & (must[i] | defs(i));
+                    changed |= in != must[next];
+                    must[next] = in;
+                }
+            }
+        }
+        summary.uses = live[entry];
+        summary.must_def = all;
+        for (int i: region) {
+            if (program[i].command == eCommands::PopR) {
+                summary.may_def |= register_mask(program[i].param);
+            } else if (program[i].command == eCommands::Call) {
+                summary.may_def |= callees[i].may_def;
+            } else if (program[i].command == eCommands::Ret) {
+                summary.must_def &= must[i];
+            }
+        }
+        return memo[entry] = summary;
+    }
+}
+
+ControlFlowGraph::ControlFlowGraph(const std::vector<Statement> &program) : program_(program) {
+    for (int i = 0; i < program_.size(); i++) {
+        if (program_[i].command == eCommands::Label) {
+            labels_[program_[i].param] = i;
+        }
+    }
+    split();
+    link();
+    mark_reachable();
+}
+
+bool ControlFlowGraph::is_jump(eCommands command) {
+    return command == eCommands::Jump || command == eCommands::Call || command == eCommands::Spawn ||
+           is_conditional(command);
+}
+
+bool ControlFlowGraph::is_conditional(eCommands command) {
+    switch (command) {
+        case eCommands::JumpE:
+        case eCommands::JumpNE:
+        case eCommands::JumpG:
+        case eCommands::JumpGE:
+        case eCommands::JumpL:
+        case eCommands::JumpLE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool ControlFlowGraph::is_memory(eCommands command) {
+    return eCommands::Load <= command && command <= eCommands::MemSum;
+}
+
+bool ControlFlowGraph::is_terminator(eCommands command) {
+    return is_jump(command) || command == eCommands::Ret || command == eCommands::End;
+}
+
+StackHints ControlFlowGraph::stack_bounds() const {
+    if (entry_ == -1) {
+        return {};
+    }
+    std::map<int, std::optional<Frame>> memo;
+    auto frame = frame_of(program_, *this, blocks_[entry_].begin, memo);
+    if (not frame) {
+        return {};
+    }
+    return {frame->peak, frame->calls};
+}
+
+std::vector<PureSubroutine> ControlFlowGraph::pure_subroutines() const {
+    std::map<int, std::optional<Summary>> memo;
+    std::set<int> targets;
+    std::vector<PureSubroutine> result;
+    for (int i = 0; i < program_.size(); i++) {
+        if (program_[i].command != eCommands::Call || not reachable(i)) {
+            continue;
+        }
+        int target = label_index(program_[i].param);
+        if (target == -1 || not targets.insert(target).second) {
+            continue;
+        }
+        if (auto summary = summary_of(program_, *this, target, memo)) {
+            result.push_back({target, -summary->floor, summary->net - summary->floor,
+                              summary->uses | (summary->may_def & ~summary->must_def), summary->may_def});
+        }
+    }
+    return result;
+}
+
+int ControlFlowGraph::label_index(const std::string &name) const {
+    auto it = labels_.find(name);
+    return it == labels_.end() ? -1 : it->second;
+}
+
+void ControlFlowGraph::split() {
+    block_of_.assign(program_.size(), -1);
+    bool after_terminator = false;
+    for (int i = 0; i < program_.size(); i++) {
+        auto command = program_[i].command;
+        // Comments and blank lines after a terminator stay in its block, they are never executed anyway
+        if (i == 0 || command == eCommands::Label || command == eCommands::Begin ||
+            (after_terminator && command != eCommands::Blank)) {
+            if (not blocks_.empty()) {
+                blocks_.back().end = i;
+            }
+            blocks_.push_back({i, i});
+            after_terminator = false;
+        }
+        block_of_[i] = static_cast<int>(blocks_.size()) - 1;
+        if (is_terminator(command)) {
+            after_terminator = true;
+        }
+        if (command == eCommands::Begin && entry_ == -1) {
+            entry_ = block_of_[i];
+        }
+    }
+    if (not blocks_.empty()) {
+        blocks_.back().end = static_cast<int>(program_.size());
+    }
+}
+
+void ControlFlowGraph::link() {
+    for (int id = 0; id < blocks_.size(); id++) {
+        auto &block = blocks_[id];
+        int last = block.end - 1;
+        while (last > block.begin && program_[last].command == eCommands::Blank) {
+            last--;
+        }
+        auto &statement = program_[last];
+        int next = id + 1 < blocks_.size() ? id + 1 : -1;
+        if (is_jump(statement.command)) {
+            int target = label_index(statement.param);
+            if (target != -1) {
+                auto kind = eEdge::Jump;
+                if (statement.command == eCommands::Call || statement.command == eCommands::Spawn) {
+                    kind = eEdge::Call;
+                } else if (is_conditional(statement.command)) {
+                    kind = eEdge::Branch;
+                }
+                block.successors.push_back({block_of_[target], kind});
+            }
+            if (statement.command != eCommands::Jump && next != -1) {
+                block.successors.push_back({next, eEdge::Fallthrough});
+            }
+        } else if (statement.command != eCommands::Ret && statement.command != eCommands::End && next != -1) {
+            block.successors.push_back({next, eEdge::Fallthrough});
+        }
+        for (auto &edge: block.successors) {
+            blocks_[edge.to].predecessors.push_back(id);
+        }
+    }
+}
+
+void ControlFlowGraph::mark_reachable() {
+    if (entry_ == -1) {
+        return;
+    }
+    std::queue<int> queue;
+    blocks_[entry_].reachable = true;
+    queue.push(entry_);
+    while (not queue.empty()) {
+        int id = queue.front();
+        queue.pop();
+        for (auto &edge: blocks_[id].successors) {
+            if (not blocks_[edge.to].reachable) {
+                blocks_[edge.to].reachable = true;
+                queue.push(edge.to);
+            }
+        }
+    }
+}
+
+void ControlFlowGraph::dump(std::ostream &out) const {
+    static const std::map<eEdge, std::string> edge_name{
+            {eEdge::Fallthrough, "fallthrough"},
+            {eEdge::Jump,        "jump"},
+            {eEdge::Branch,      "branch"},
+            {eEdge::Call,        "call"}
+    };
+    for (int id = 0; id < blocks_.size(); id++) {
+        auto &block = blocks_[id];
+        out << "block " << id << (id == entry_ ? " (entry)" : "") << (block.reachable ? "" : " (unreachable)")
+            << ":\n";
+        for (int i = block.begin; i < block.end; i++) {
+            if (program_[i].command == eCommands::Blank) {
+                continue;
+            }
+            out << "    " << program_[i].line << ": " << command_name.at(program_[i].command);
+            if (not program_[i].param.empty()) {
+                out << ' ' << program_[i].param;
+            }
+            out << '\n';
+        }
+        for (auto &edge: block.successors) {
+            out << "    -> " << edge.to << " (" << edge_name.at(edge.kind) << ")\n";
+        }
+    }
+}
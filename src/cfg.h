@@ -0,0 +1,67 @@
+#pragma once
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "memo.h"
+#include "parser.h"
+
+enum class eEdge {
+    Fallthrough, Jump, Branch, Call
+};
+
+struct Edge {
+    int to;
+    eEdge kind;
+};
+
+struct BasicBlock {
+    int begin;
+    int end;
+    std::vector<Edge> successors;
+    std::vector<int> predecessors;
+    bool reachable = false;
+};
+
+class ControlFlowGraph {
+public:
+    explicit ControlFlowGraph(const std::vector<Statement> &);
+
+    [[nodiscard]] const std::vector<BasicBlock> &blocks() const { return blocks_; }
+
+    [[nodiscard]] int entry() const { return entry_; }
+
+    [[nodiscard]] int block_of(int index) const { return block_of_[index]; }
+
+    [[nodiscard]] int label_index(const std::string &) const;
+
+    [[nodiscard]] bool reachable(int index) const { return blocks_[block_of_[index]].reachable; }
+
+    [[nodiscard]] StackHints stack_bounds() const;
+
+    [[nodiscard]] std::vector<PureSubroutine> pure_subroutines() const;
+
+    void dump(std::ostream &) const;
+
+    static bool is_jump(eCommands);
+
+    static bool is_conditional(eCommands);
+
+    static bool is_memory(eCommands);
+
+    static bool is_terminator(eCommands);
+
+private:
+    const std::vector<Statement> &program_;
+    std::vector<BasicBlock> blocks_;
+    std::vector<int> block_of_;
+    std::map<std::string, int> labels_;
+    int entry_ = -1;
+
+    void split();
+
+    void link();
+
+    void mark_reachable();
+};
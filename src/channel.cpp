@@ -0,0 +1,68 @@
+#include <bit>
+#include <thread>
+#include "channel.h"
+
+Channel::Channel(uint32_t capacity) : mask_(std::bit_ceil(std::max<uint32_t>(capacity, 1)) - 1),
+                                      buffer_(std::make_unique<int[]>(mask_ + 1)) {}
+
+Switchboard::Switchboard(int participants) : active_(participants), waits_(participants) {}
+
+bool Switchboard::wait(int participant, const Channel *channel, bool sending) {
+    Wait wait{channel, sending};
+    for (int spin = 0; spin < 256; spin++) {
+        if (ready(wait)) {
+            return true;
+        }
+        std::this_thread::yield();
+    }
+    std::unique_lock lock(mutex_);
+    sleepers_.fetch_add(1);
+    active_--;
+    waits_[participant] = wait;
+    while (not ready(wait) && not deadlock_) {
+        if (active_ == 0) {
+            bool runnable = false;
+            for (auto &other: waits_) {
+                runnable = runnable || ready(other);
+            }
+            if (not runnable) {
+                deadlock_ = true;
+                changed_.notify_all();
+                break;
+            }
+            epoch_++;
+            changed_.notify_all();
+        }
+        auto epoch = epoch_;
+        changed_.wait(lock, [&] { return epoch_ != epoch || deadlock_; });
+    }
+    waits_[participant] = {};
+    active_++;
+    sleepers_.fetch_sub(1);
+    return not deadlock_;
+}
+
+void Switchboard::finish(int participant) {
+    std::lock_guard lock(mutex_);
+    active_--;
+    epoch_++;
+    changed_.notify_all();
+}
+
+void Switchboard::wake() {
+    std::lock_guard lock(mutex_);
+    epoch_++;
+    changed_.notify_all();
+}
+
+void Channels::connect(int number, Channel *channel, bool sending) {
+    auto &endpoints = sending ? send_ : recv_;
+    if (number >= endpoints.size()) {
+        endpoints.resize(number + 1, nullptr);
+    }
+    endpoints[number] = channel;
+}
+
+bool Channels::connected(int number, bool sending) const {
+    return (sending ? sender(number) : receiver(number)) != nullptr;
+}
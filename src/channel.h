@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class Channel {
+public:
+    static constexpr uint32_t default_capacity = 1024;
+
+    explicit Channel(uint32_t capacity = default_capacity);
+
+    Channel(const Channel &) = delete;
+
+    Channel &operator=(const Channel &) = delete;
+
+    bool push(int value) {
+        auto tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ > mask_) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ > mask_) {
+                return false;
+            }
+        }
+        buffer_[tail & mask_] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(int &value) {
+        auto head = head_.load(std::memory_order_relaxed);
+        if (head == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head == tail_cache_) {
+                return false;
+            }
+        }
+        value = buffer_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    [[nodiscard]] bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]] bool full() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire) > mask_;
+    }
+
+    [[nodiscard]] uint32_t capacity() const { return mask_ + 1; }
+
+private:
+    alignas(64) std::atomic<uint32_t> head_{0};
+    uint32_t tail_cache_ = 0;
+    alignas(64) std::atomic<uint32_t> tail_{0};
+    uint32_t head_cache_ = 0;
+    alignas(64) uint32_t mask_;
+    std::unique_ptr<int[]> buffer_;
+};
+
+class Switchboard {
+public:
+    explicit Switchboard(int participants);
+
+    void progress() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers_.load(std::memory_order_relaxed) > 0) {
+            wake();
+        }
+    }
+
+    bool wait(int participant, const Channel *channel, bool sending);
+
+    void finish(int participant);
+
+private:
+    struct Wait {
+        const Channel *channel = nullptr;
+        bool sending = false;
+    };
+
+    static bool ready(const Wait &wait) {
+        return wait.channel != nullptr && (wait.sending ? not wait.channel->full() : not wait.channel->empty());
+    }
+
+    void wake();
+
+    std::atomic<int> sleepers_{0};
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    uint64_t epoch_ = 0;
+    int active_;
+    bool deadlock_ = false;
+    std::vector<Wait> waits_;
+};
+
+class Channels {
+public:
+    explicit Channels(Switchboard *board = nullptr) : board_(board) {}
+
+    void connect(int number, Channel *channel, bool sending);
+
+    [[nodiscard]] bool connected(int number, bool sending) const;
+
+    [[nodiscard]] Channel *sender(int number) const {
+        return 0 <= number && number < send_.size() ? send_[number] : nullptr;
+    }
+
+    [[nodiscard]] Channel *receiver(int number) const {
+        return 0 <= number && number < recv_.size() ? recv_[number] : nullptr;
+    }
+
+    void progress() {
+        if (board_) {
+            board_->progress();
+        }
+    }
+
+private:
+    Switchboard *board_;
+    std::vector<Channel *> send_;
+    std::vector<Channel *> recv_;
+};
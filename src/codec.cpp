@@ -0,0 +1,266 @@
+#include <algorithm>
+#include <stdexcept>
+#include "codec.h"
+
+static bool takes_label(eCommands command) {
+    return (eCommands::Jump <= command && command <= eCommands::Call) || command == eCommands::Spawn;
+}
+
+static bool takes_integer(eCommands command) {
+    return command == eCommands::Push || command == eCommands::Send || command == eCommands::Recv ||
+           command == eCommands::Memory;
+}
+
+static bool takes_register(eCommands command) {
+    return command == eCommands::PushR || command == eCommands::PopR || command == eCommands::LoadR ||
+           command == eCommands::StoreR;
+}
+
+static uint32_t zigzag(int32_t value) {
+    return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+static int32_t unzigzag(uint32_t value) {
+    return static_cast<int32_t>((value >> 1) ^ (~(value & 1) + 1));
+}
+
+void Codec::put(std::string &out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+void Codec::put_signed(std::string &out, int32_t value) {
+    put(out, zigzag(value));
+}
+
+uint32_t Codec::get(const std::string &in, size_t &offset) {
+    uint32_t value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (offset >= in.size()) {
+            throw std::runtime_error("Binary file is truncated");
+        }
+        auto byte = static_cast<uint8_t>(in[offset++]);
+        value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+        if (byte < 0x80) {
+            return value;
+        }
+    }
+    throw std::runtime_error("Binary file is corrupted");
+}
+
+int32_t Codec::get_signed(const std::string &in, size_t &offset) {
+    return unzigzag(get(in, offset));
+}
+
+std::pair<std::string, std::string> Codec::compress(const Code &code, Symbols &symbols) {
+    std::unordered_map<std::string, int> index;
+    for (int i = 0; i < symbols.size(); i++) {
+        index[symbols[i].first] = i;
+    }
+    std::vector<std::string> tokens;
+    tokens.reserve(code.size());
+    for (int pc = 0; pc < code.size(); pc++) {
+        auto &[command, param] = code[pc];
+        std::string token(1, static_cast<char>(command));
+        if (takes_integer(command)) {
+            put_signed(token, std::stoi(param));
+        } else if (takes_register(command)) {
+            put(token, RegisterType::index(param));
+        } else if (takes_label(command)) {
+            auto it = index.find(param);
+            if (it != index.end() && symbols[it->second].second >= 0) {
+                put(token, zigzag(symbols[it->second].second - pc) + 1);
+            } else {
+                if (it == index.end()) {
+                    it = index.emplace(param, static_cast<int>(symbols.size())).first;
+                    symbols.emplace_back(param, -1);
+                }
+                put(token, 0);
+                put(token, it->second);
+            }
+        }
+        tokens.push_back(std::move(token));
+    }
+
+    std::unordered_map<std::string, uint32_t> counts;
+    for (size_t i = 0; i < tokens.size(); i++) {
+        std::string sequence = tokens[i];
+        for (size_t n = 2; n <= max_sequence && i + n <= tokens.size(); n++) {
+            sequence += tokens[i + n - 1];
+            counts[sequence]++;
+        }
+    }
+    std::vector<std::pair<int64_t, std::string>> candidates;
+    for (auto &[sequence, count]: counts) {
+        auto size = static_cast<int64_t>(sequence.size());
+        int64_t saving = count * (size - 2) - size - 1;
+        if (saving > 0) {
+            candidates.emplace_back(saving, sequence);
+        }
+    }
+    counts.clear();
+    std::sort(candidates.begin(), candidates.end(), std::greater<>());
+    candidates.resize(std::min(candidates.size(), max_entries));
+
+    auto replace = [&tokens](const std::unordered_map<std::string, uint32_t> &entries, std::vector<uint32_t> &uses,
+                             std::string *out) {
+        std::string sequences[max_sequence + 1];
+        for (size_t i = 0; i < tokens.size();) {
+            size_t longest = 0;
+            sequences[1] = tokens[i];
+            for (size_t n = 2; n <= max_sequence && i + n <= tokens.size(); n++) {
+                sequences[n] = sequences[n - 1] + tokens[i + n - 1];
+                if (entries.contains(sequences[n])) {
+                    longest = n;
+                }
+            }
+            if (longest == 0) {
+                if (out) {
+                    *out += tokens[i];
+                }
+                i++;
+                continue;
+            }
+            auto entry = entries.at(sequences[longest]);
+            uses[entry]++;
+            if (out) {
+                out->push_back(static_cast<char>(reference));
+                put(*out, entry);
+            }
+            i += longest;
+        }
+    };
+
+    std::unordered_map<std::string, uint32_t> entries;
+    for (auto &[saving, sequence]: candidates) {
+        entries.emplace(sequence, static_cast<uint32_t>(entries.size()));
+    }
+    std::vector<uint32_t> uses(entries.size());
+    replace(entries, uses, nullptr);
+
+    std::string dictionary;
+    std::vector<std::string> kept;
+    for (auto &[saving, sequence]: candidates) {
+        auto size = static_cast<int64_t>(sequence.size());
+        if (uses[entries[sequence]] * (size - 2) > size + 1) {
+            kept.push_back(sequence);
+        }
+    }
+    entries.clear();
+    put(dictionary, static_cast<uint32_t>(kept.size()));
+    for (auto &sequence: kept) {
+        entries.emplace(sequence, static_cast<uint32_t>(entries.size()));
+        put(dictionary, static_cast<uint32_t>(sequence.size()));
+        dictionary += sequence;
+    }
+    std::string out;
+    uses.assign(entries.size(), 0);
+    replace(entries, uses, &out);
+    return {dictionary, out};
+}
+
+void Codec::decompress(const std::string &dictionary, const std::string &code, const Symbols &symbols,
+                       Source &program) {
+    std::unordered_map<std::string, int> targets;
+    for (auto &[name, pc]: symbols) {
+        targets[name] = pc;
+    }
+    std::unordered_map<int, std::string> names;
+    for (auto &[name, pc]: targets) {
+        if (pc >= 0) {
+            names.emplace(pc, name);
+        }
+    }
+    std::vector<std::string> entries;
+    size_t offset = 0;
+    if (not dictionary.empty()) {
+        entries.resize(get(dictionary, offset));
+        for (auto &entry: entries) {
+            size_t size = get(dictionary, offset);
+            if (offset + size > dictionary.size()) {
+                throw std::runtime_error("Binary file is truncated");
+            }
+            entry = dictionary.substr(offset, size);
+            offset += size;
+        }
+    }
+    offset = 0;
+    while (offset < code.size()) {
+        if (static_cast<uint8_t>(code[offset]) != reference) {
+            offset = expand(code, offset, names, symbols, program);
+            continue;
+        }
+        offset++;
+        auto index = get(code, offset);
+        if (index >= entries.size()) {
+            throw std::runtime_error("Binary file is corrupted");
+        }
+        auto &entry = entries[index];
+        for (size_t at = 0; at < entry.size();) {
+            at = expand(entry, at, names, symbols, program);
+        }
+    }
+}
+
+size_t Codec::expand(const std::string &in, size_t offset, const std::unordered_map<int, std::string> &names,
+                     const Symbols &symbols, Source &program) {
+    auto command = static_cast<eCommands>(in[offset++]);
+    if (static_cast<size_t>(command) >= command_count) {
+        throw std::runtime_error("Binary file is corrupted");
+    }
+    std::string param;
+    if (takes_integer(command)) {
+        param = std::to_string(get_signed(in, offset));
+    } else if (takes_register(command)) {
+        auto reg = get(in, offset);
+        if (reg >= RegisterType::available.size()) {
+            throw std::runtime_error("Binary file is corrupted");
+        }
+        param = RegisterType::available[reg];
+    } else if (takes_label(command)) {
+        auto value = get(in, offset);
+        if (value == 0) {
+            auto symbol = get(in, offset);
+            if (symbol >= symbols.size()) {
+                throw std::runtime_error("Binary file is corrupted");
+            }
+            param = symbols[symbol].first;
+        } else {
+            auto it = names.find(static_cast<int>(program.size()) + unzigzag(value - 1));
+            if (it == names.end()) {
+                throw std::runtime_error("Binary file is corrupted");
+            }
+            param = it->second;
+        }
+    }
+    program.emplace_back(command_name[command], std::move(param));
+    return offset;
+}
+
+std::string Codec::compress_debug(const std::vector<DebugLine> &lines) {
+    std::string out;
+    DebugLine previous{0, 0, -1};
+    for (auto &entry: lines) {
+        put_signed(out, entry.line - previous.line);
+        put(out, static_cast<uint32_t>(entry.column));
+        put_signed(out, entry.label - previous.label);
+        previous = entry;
+    }
+    return out;
+}
+
+std::vector<DebugLine> Codec::decompress_debug(const std::string &in) {
+    std::vector<DebugLine> lines;
+    DebugLine previous{0, 0, -1};
+    for (size_t offset = 0; offset < in.size();) {
+        DebugLine entry;
+        entry.line = previous.line + get_signed(in, offset);
+        entry.column = static_cast<int32_t>(get(in, offset));
+        entry.label = previous.label + get_signed(in, offset);
+        lines.push_back(previous = entry);
+    }
+    return lines;
+}
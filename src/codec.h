@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "commands.h"
+
+struct DebugLine {
+    int32_t line = -1;
+    int32_t column = 0;
+    int32_t label = -1;
+};
+
+static const std::string compressed_magic = std::string("EMZ\x01", 4);
+
+class Codec {
+public:
+    using Code = std::vector<std::pair<eCommands, std::string>>;
+    using Symbols = std::vector<std::pair<std::string, int>>;
+    using Source = std::vector<std::tuple<std::string, std::string>>;
+
+    static constexpr size_t max_entries = 127;
+    static constexpr size_t max_sequence = 8;
+
+    static std::pair<std::string, std::string> compress(const Code &, Symbols &);
+
+    static void decompress(const std::string &dictionary, const std::string &code, const Symbols &, Source &);
+
+    static std::string compress_debug(const std::vector<DebugLine> &);
+
+    static std::vector<DebugLine> decompress_debug(const std::string &);
+
+private:
+    static constexpr uint8_t reference = 0xFF;
+
+    static void put(std::string &, uint32_t);
+
+    static void put_signed(std::string &, int32_t);
+
+    static uint32_t get(const std::string &, size_t &);
+
+    static int32_t get_signed(const std::string &, size_t &);
+
+    static size_t expand(const std::string &, size_t, const std::unordered_map<int, std::string> &names,
+                         const Symbols &, Source &);
+};
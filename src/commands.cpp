@@ -1,8 +1,32 @@
+#include <climits>
 #include "commands.h"
+#include "channel.h"
 #include "exc.h"
+#include "fence.h"
+#include "kernels.h"
+#include "memo.h"
+#include "scheduler.h"
+
+int BaseCommand::raise(int status, int32_t operand) {
+    if (status >= trap(eTrap::Halt)) {
+        return status;
+    }
+    Trap fault{static_cast<eTrap>(-status)};
+    fault.operand = operand;
+    if (fault.kind == eTrap::UnresolvedLabel) {
+        throw InvalidArgumentException(fault.message());
+    }
+    throw std::runtime_error(fault.message());
+}
+
+int BaseParamLessCommand::run(std::string param, int line, Context *context) {
+    int status = fenced(*context, [&] { return process(line, context); });
+    context->flush();
+    return raise(status, 0);
+}
 
-int BaseParamLessCommand::run(std::string param, int line, shared_stack stack) {
-    return process(line, stack);
+int BaseParamLessCommand::execute(int32_t operand, int line, Context *context) {
+    return process(line, context);
 }
 
 void BaseParamLessCommand::configure(std::string param, int line) {
@@ -12,8 +36,12 @@ void BaseParamLessCommand::configure(std::string param, int line) {
     setup(line);
 }
 
+int32_t BaseParamLessCommand::encode(const std::string &param) {
+    return 0;
+}
+
 
-int BaseIntegerCommand::clear_param(std::string &param, int line) {
+int BaseIntegerCommand::clear_param(const std::string &param, int line) {
     try {
         return std::stoi(param);
     } catch (std::out_of_range &e) {
@@ -21,9 +49,13 @@ int BaseIntegerCommand::clear_param(std::string &param, int line) {
     }
 }
 
-int BaseIntegerCommand::run(std::string param, int line, shared_stack stack) {
+int BaseIntegerCommand::run(std::string param, int line, Context *context) {
     int value = clear_param(param, line);
-    return process(value, line, stack);
+    return raise(fenced(*context, [&] { return process(value, line, context); }), value);
+}
+
+int BaseIntegerCommand::execute(int32_t operand, int line, Context *context) {
+    return process(operand, line, context);
 }
 
 void BaseIntegerCommand::configure(std::string param, int line) {
@@ -31,25 +63,66 @@ void BaseIntegerCommand::configure(std::string param, int line) {
     setup(value, line);
 }
 
+int32_t BaseIntegerCommand::encode(const std::string &param) {
+    return clear_param(param, -1);
+}
+
 
-int BaseRegisterCommand::run(std::string param, int line, shared_stack stack) {
-    return process(RegisterType::get(param), line, stack);
+int BaseRegisterCommand::run(std::string param, int line, Context *context) {
+    RegisterType::get(param);
+    int reg = RegisterType::index(param);
+    return raise(fenced(*context, [&] { return process(reg, line, context); }), reg);
+}
+
+int BaseRegisterCommand::execute(int32_t operand, int line, Context *context) {
+    return process(operand, line, context);
 }
 
 void BaseRegisterCommand::configure(std::string param, int line) {
     setup(RegisterType::get(param), line);
 }
 
+int32_t BaseRegisterCommand::encode(const std::string &param) {
+    RegisterType::get(param);
+    return RegisterType::index(param);
+}
 
-int BaseLabelCommand::run(std::string param, int line, shared_stack stack) {
-    return process(LabelType::get(param), line, stack);
+
+int BaseLabelCommand::run(std::string param, int line, Context *context) {
+    int target = LabelType::get(param).target();
+    return raise(fenced(*context, [&] { return process(target, line, context); }), target);
+}
+
+int BaseLabelCommand::execute(int32_t operand, int line, Context *context) {
+    return process(operand, line, context);
 }
 
 void BaseLabelCommand::configure(std::string param, int line) {
     setup(LabelType::get(param), line);
 }
 
-int BeginCommand::process(int line, shared_stack stack) {
+int32_t BaseLabelCommand::encode(const std::string &param) {
+    return LabelType::get(param).target();
+}
+
+static bool underflows(const ArenaStack<int> &stack, uint32_t count) {
+    return not guarded_stacks && stack.size() < count;
+}
+
+static bool overflows(const ArenaStack<int> &stack) {
+    return not guarded_stacks && stack.full();
+}
+
+static bool in_memory(const Context *context, int address, int count) {
+    return 0 <= address && 0 <= count && static_cast<uint32_t>(address) <= context->memory_size &&
+           static_cast<uint32_t>(count) <= context->memory_size - static_cast<uint32_t>(address);
+}
+
+static int jump_to(int target) {
+    return target < 0 ? trap(eTrap::UnresolvedLabel) : target;
+}
+
+int BeginCommand::process(int line, Context *context) {
     return line + 1;
 }
 
@@ -64,8 +137,8 @@ void BeginCommand::clear() {
     line_ = -1;
 }
 
-int EndCommand::process(int line, shared_stack stack) {
-    return -1;
+int EndCommand::process(int line, Context *context) {
+    return trap(eTrap::Halt);
 }
 
 void EndCommand::setup(int line) {
@@ -80,101 +153,172 @@ void EndCommand::clear() {
 }
 
 
-int PushCommand::process(int val, int line, shared_stack stack) {
-    stack->data.push(val);
+int PushCommand::process(int val, int line, Context *context) {
+    if (overflows(context->data)) {
+        return trap(eTrap::StackOverflow);
+    }
+    context->data.push(val);
     return line + 1;
 }
 
 void PushCommand::setup(int val, int line) {}
 
 
-int PopCommand::process(int line, shared_stack stack) {
-    stack->data.pop();
+int PopCommand::process(int line, Context *context) {
+    if (underflows(context->data, 1)) {
+        return trap(eTrap::StackUnderflow);
+    }
+    context->data.pop();
     return line + 1;
 }
 
 void PopCommand::setup(int line) {}
 
 
-int PushRCommand::process(RegisterType &val, int line, shared_stack stack) {
-    stack->data.push(val.value());
+int PushRCommand::process(int reg, int line, Context *context) {
+    if (overflows(context->data)) {
+        return trap(eTrap::StackOverflow);
+    }
+    context->data.push(context->registers[reg]);
     return line + 1;
 }
 
 void PushRCommand::setup(RegisterType &val, int line) {}
 
 
-int PopRCommand::process(RegisterType &val, int line, shared_stack stack) {
-    val.value() = stack->data.top();
-    stack->data.pop();
+int PopRCommand::process(int reg, int line, Context *context) {
+    if (underflows(context->data, 1)) {
+        return trap(eTrap::StackUnderflow);
+    }
+    context->registers[reg] = context->data.top();
+    context->data.pop();
     return line + 1;
 }
 
 void PopRCommand::setup(RegisterType &val, int line) {}
 
-int AddCommand::process(int line, shared_stack stack) {
-    int first = stack->data.top();
-    stack->data.pop();
-    int second = stack->data.top();
-    stack->data.pop();
-    stack->data.push(first + second);
+int AddCommand::process(int line, Context *context) {
+    if (underflows(context->data, 2)) {
+        return trap(eTrap::StackUnderflow);
+    }
+    int first = context->data.top();
+    context->data.pop();
+    int second = context->data.top();
+    context->data.pop();
+    context->data.push(first + second);
     return line + 1;
 }
 
 void AddCommand::setup(int line) {}
 
-int SubCommand::process(int line, shared_stack stack) {
-    int first = stack->data.top();
-    stack->data.pop();
-    int second = stack->data.top();
-    stack->data.pop();
-    stack->data.push(second - first);
+int SubCommand::process(int line, Context *context) {
+    if (underflows(context->data, 2)) {
+        return trap(eTrap::StackUnderflow);
+    }
+    int first = context->data.top();
+    context->data.pop();
+    int second = context->data.top();
+    context->data.pop();
+    context->data.push(second - first);
     return line + 1;
 }
 
 void SubCommand::setup(int line) {}
 
-int MulCommand::process(int line, shared_stack stack) {
-    int first = stack->data.top();
-    stack->data.pop();
-    int second = stack->data.top();
-    stack->data.pop();
-    stack->data.push(first * second);
+int MulCommand::process(int line, Context *context) {
+    if (underflows(context->data, 2)) {
+        return trap(eTrap::StackUnderflow);
+    }
+    int first = context->data.top();
+    context->data.pop();
+    int second = context->data.top();
+    context->data.pop();
+    context->data.push(first * second);
     return line + 1;
 }
 
 void MulCommand::setup(int line) {}
 
-int DivCommand::process(int line, shared_stack stack) {
-    int first = stack->data.top();
-    stack->data.pop();
-    int second = stack->data.top();
-    stack->data.pop();
-    stack->data.push(second / first);
+int DivCommand::process(int line, Context *context) {
+    if (underflows(context->data, 2)) {
+        return trap(eTrap::StackUnderflow);
+    }
+    int first = context->data.top();
+    if (first == 0) {
+        return trap(eTrap::DivisionByZero);
+    }
+    context->data.pop();
+    int second = context->data.top();
+    if (first == -1 && second == INT_MIN) {
+        context->data.push(first);
+        return trap(eTrap::DivisionOverflow);
+    }
+    context->data.pop();
+    context->data.push(second / first);
     return line + 1;
 }
 
 void DivCommand::setup(int line) {}
 
-int InCommand::process(int line, shared_stack stack) {
-    int value = 0;
-    std::cout << "Input number: ";
-    std::cin >> value;
-    stack->data.push(value);
+int InCommand::process(int line, Context *context) {
+    if (overflows(context->data)) {
+        return trap(eTrap::StackOverflow);
+    }
+    context->data.push(context->read());
     return line + 1;
 }
 
 void InCommand::setup(int line) {}
 
-int OutCommand::process(int line, shared_stack stack) {
-    std::cout << stack->data.top() << std::endl;
-    stack->data.pop();
+int OutCommand::process(int line, Context *context) {
+    if (underflows(context->data, 1)) {
+        return trap(eTrap::StackUnderflow);
+    }
+    context->write(context->data.top());
+    context->data.pop();
     return line + 1;
 }
 
 void OutCommand::setup(int line) {}
 
-int LabelCommand::process(LabelType &val, int line, shared_stack stack) {
+int SendCommand::process(int channel, int line, Context *context) {
+    if (underflows(context->data, 1)) {
+        return trap(eTrap::StackUnderflow);
+    }
+    auto *endpoint = context->channels ? context->channels->sender(channel) : nullptr;
+    if (endpoint == nullptr) {
+        return trap(eTrap::Disconnected);
+    }
+    if (not endpoint->push(context->data.top())) {
+        return trap(eTrap::Blocked);
+    }
+    context->data.pop();
+    context->channels->progress();
+    return line + 1;
+}
+
+void SendCommand::setup(int channel, int line) {}
+
+int RecvCommand::process(int channel, int line, Context *context) {
+    if (overflows(context->data)) {
+        return trap(eTrap::StackOverflow);
+    }
+    auto *endpoint = context->channels ? context->channels->receiver(channel) : nullptr;
+    if (endpoint == nullptr) {
+        return trap(eTrap::Disconnected);
+    }
+    int value;
+    if (not endpoint->pop(value)) {
+        return trap(eTrap::Blocked);
+    }
+    context->data.push(value);
+    context->channels->progress();
+    return line + 1;
+}
+
+void RecvCommand::setup(int channel, int line) {}
+
+int LabelCommand::process(int target, int line, Context *context) {
     return line + 1;
 }
 
@@ -182,126 +326,305 @@ void LabelCommand::setup(LabelType &val, int line) {
     val.line() = line;
 }
 
-int JumpCommand::process(LabelType &val, int line, shared_stack stack) {
-    if (val.line() == -1) {
-        throw InvalidArgumentException("Can not find label \"" + val.name() + "\" to jump");
-    }
-    return val.line();
+int JumpCommand::process(int target, int line, Context *context) {
+    return jump_to(target);
 }
 
 void JumpCommand::setup(LabelType &val, int line) {}
 
-int JumpEqualCommand::process(LabelType &val, int line, shared_stack stack) {
-    int first = stack->data.top();
-    stack->data.pop();
-    int second = stack->data.top();
-    stack->data.push(first);
+int JumpEqualCommand::process(int target, int line, Context *context) {
+    if (underflows(context->data, 2)) {
+        return trap(eTrap::StackUnderflow);
+    }
+    int first = context->data.top();
+    context->data.pop();
+    int second = context->data.top();
+    context->data.push(first);
     if (first != second) {
         return line + 1;
     }
-    if (val.line() == -1) {
-        throw InvalidArgumentException("Can not find label \"" + val.name() + "\" to jump");
-    }
-    return val.line();
+    return jump_to(target);
 }
 
 void JumpEqualCommand::setup(LabelType &val, int line) {}
 
-int JumpNotEqualCommand::process(LabelType &val, int line, shared_stack stack) {
-    int first = stack->data.top();
-    stack->data.pop();
-    int second = stack->data.top();
-    stack->data.push(first);
+int JumpNotEqualCommand::process(int target, int line, Context *context) {
+    if (underflows(context->data, 2)) {
+        return trap(eTrap::StackUnderflow);
+    }
+    int first = context->data.top();
+    context->data.pop();
+    int second = context->data.top();
+    context->data.push(first);
     if (first == second) {
         return line + 1;
     }
-    if (val.line() == -1) {
-        throw InvalidArgumentException("Can not find label \"" + val.name() + "\" to jump");
-    }
-    return val.line();
+    return jump_to(target);
 }
 
 void JumpNotEqualCommand::setup(LabelType &val, int line) {}
 
-int JumpGreaterCommand::process(LabelType &val, int line, shared_stack stack) {
-    int first = stack->data.top();
-    stack->data.pop();
-    int second = stack->data.top();
-    stack->data.push(first);
+int JumpGreaterCommand::process(int target, int line, Context *context) {
+    if (underflows(context->data, 2)) {
+        return trap(eTrap::StackUnderflow);
+    }
+    int first = context->data.top();
+    context->data.pop();
+    int second = context->data.top();
+    context->data.push(first);
     if (first <= second) {
         return line + 1;
     }
-    if (val.line() == -1) {
-        throw InvalidArgumentException("Can not find label \"" + val.name() + "\" to jump");
-    }
-    return val.line();
+    return jump_to(target);
 }
 
 void JumpGreaterCommand::setup(LabelType &val, int line) {}
 
-int JumpGreaterOrEqualCommand::process(LabelType &val, int line, shared_stack stack) {
-    int first = stack->data.top();
-    stack->data.pop();
-    int second = stack->data.top();
-    stack->data.push(first);
+int JumpGreaterOrEqualCommand::process(int target, int line, Context *context) {
+    if (underflows(context->data, 2)) {
+        return trap(eTrap::StackUnderflow);
+    }
+    int first = context->data.top();
+    context->data.pop();
+    int second = context->data.top();
+    context->data.push(first);
     if (first < second) {
         return line + 1;
     }
-    if (val.line() == -1) {
-        throw InvalidArgumentException("Can not find label \"" + val.name() + "\" to jump");
-    }
-    return val.line();
+    return jump_to(target);
 }
 
 void JumpGreaterOrEqualCommand::setup(LabelType &val, int line) {}
 
-int JumpLessCommand::process(LabelType &val, int line, shared_stack stack) {
-    int first = stack->data.top();
-    stack->data.pop();
-    int second = stack->data.top();
-    stack->data.push(first);
+int JumpLessCommand::process(int target, int line, Context *context) {
+    if (underflows(context->data, 2)) {
+        return trap(eTrap::StackUnderflow);
+    }
+    int first = context->data.top();
+    context->data.pop();
+    int second = context->data.top();
+    context->data.push(first);
     if (first >= second) {
         return line + 1;
     }
-    if (val.line() == -1) {
-        throw InvalidArgumentException("Can not find label \"" + val.name() + "\" to jump");
-    }
-    return val.line();
+    return jump_to(target);
 }
 
 void JumpLessCommand::setup(LabelType &val, int line) {}
 
-int JumpLessOrEqualCommand::process(LabelType &val, int line, shared_stack stack) {
-    int first = stack->data.top();
-    stack->data.pop();
-    int second = stack->data.top();
-    stack->data.push(first);
+int JumpLessOrEqualCommand::process(int target, int line, Context *context) {
+    if (underflows(context->data, 2)) {
+        return trap(eTrap::StackUnderflow);
+    }
+    int first = context->data.top();
+    context->data.pop();
+    int second = context->data.top();
+    context->data.push(first);
     if (first > second) {
         return line + 1;
     }
-    if (val.line() == -1) {
-        throw InvalidArgumentException("Can not find label \"" + val.name() + "\" to jump");
-    }
-    return val.line();
+    return jump_to(target);
 }
 
 void JumpLessOrEqualCommand::setup(LabelType &val, int line) {}
 
 
-int CallCommand::process(LabelType &val, int line, shared_stack stack) {
-    if (val.line() == -1) {
-        throw InvalidArgumentException("Can not find label \"" + val.name() + "\" to jump");
+int CallCommand::process(int target, int line, Context *context) {
+    if (target < 0) {
+        return trap(eTrap::UnresolvedLabel);
+    }
+    if (context->memo) {
+        if (auto next = context->memo->enter(target, line, context)) {
+            return *next;
+        }
     }
-    stack->call.push(line);
-    return val.line();
+    if (overflows(context->call)) {
+        return trap(eTrap::StackOverflow);
+    }
+    context->call.push(line);
+    return target;
 }
 
 void CallCommand::setup(LabelType &val, int line) {}
 
-int RetCommand::process(int line, shared_stack stack) {
-    int to = stack->call.top();
-    stack->call.pop();
+int RetCommand::process(int line, Context *context) {
+    if (underflows(context->call, 1)) {
+        return trap(eTrap::CallStackUnderflow);
+    }
+    int to = context->call.top();
+    context->call.pop();
+    if (context->memo) {
+        context->memo->leave(context);
+    }
     return to + 1;
 }
 
-void RetCommand::setup(int line) {}
\ No newline at end of file
+void RetCommand::setup(int line) {}
+
+int SpawnCommand::process(int target, int line, Context *context) {
+    if (target < 0) {
+        return trap(eTrap::UnresolvedLabel);
+    }
+    if (underflows(context->data, 1)) {
+        return trap(eTrap::StackUnderflow);
+    }
+    if (context->scheduler == nullptr) {
+        return trap(eTrap::BadTask);
+    }
+    auto count = static_cast<uint32_t>(context->data.top());
+    if (context->data.size() - 1 < count) {
+        return trap(eTrap::StackUnderflow);
+    }
+    context->data.pop();
+    context->data.push(context->scheduler->spawn(target, count, context));
+    return line + 1;
+}
+
+void SpawnCommand::setup(LabelType &val, int line) {}
+
+int JoinCommand::process(int line, Context *context) {
+    if (underflows(context->data, 1)) {
+        return trap(eTrap::StackUnderflow);
+    }
+    if (context->scheduler == nullptr) {
+        return trap(eTrap::BadTask);
+    }
+    int status = context->scheduler->join(context);
+    return status < 0 ? status : line + 1;
+}
+
+void JoinCommand::setup(int line) {}
+
+int MemoryCommand::process(int size, int line, Context *context) {
+    return line + 1;
+}
+
+void MemoryCommand::setup(int size, int line) {
+    if (size < 0 || size > Context::memory_limit) {
+        throw InvalidArgumentException("MEMORY size must be between 0 and " + std::to_string(Context::memory_limit));
+    }
+    if (line_ != -1) {
+        throw UniqueException("MEMORY command must appear only once", line);
+    }
+    size_ = size;
+    line_ = line;
+}
+
+void MemoryCommand::clear() {
+    size_ = 0;
+    line_ = -1;
+}
+
+int LoadCommand::process(int line, Context *context) {
+    if (underflows(context->data, 1)) {
+        return trap(eTrap::StackUnderflow);
+    }
+    int address = context->data.top();
+    if (not in_memory(context, address, 1)) {
+        return trap(eTrap::BadAddress);
+    }
+    context->data.top() = context->memory[address];
+    return line + 1;
+}
+
+void LoadCommand::setup(int line) {}
+
+int StoreCommand::process(int line, Context *context) {
+    if (underflows(context->data, 2)) {
+        return trap(eTrap::StackUnderflow);
+    }
+    int address = context->data.peek(0);
+    int value = context->data.peek(1);
+    if (not in_memory(context, address, 1)) {
+        return trap(eTrap::BadAddress);
+    }
+    context->memory[address] = value;
+    context->data.pop();
+    context->data.pop();
+    return line + 1;
+}
+
+void StoreCommand::setup(int line) {}
+
+int LoadRCommand::process(int reg, int line, Context *context) {
+    if (overflows(context->data)) {
+        return trap(eTrap::StackOverflow);
+    }
+    int address = context->registers[reg];
+    if (not in_memory(context, address, 1)) {
+        return trap(eTrap::BadAddress);
+    }
+    context->data.push(context->memory[address]);
+    return line + 1;
+}
+
+void LoadRCommand::setup(RegisterType &val, int line) {}
+
+int StoreRCommand::process(int reg, int line, Context *context) {
+    if (underflows(context->data, 1)) {
+        return trap(eTrap::StackUnderflow);
+    }
+    int address = context->registers[reg];
+    if (not in_memory(context, address, 1)) {
+        return trap(eTrap::BadAddress);
+    }
+    context->memory[address] = context->data.top();
+    context->data.pop();
+    return line + 1;
+}
+
+void StoreRCommand::setup(RegisterType &val, int line) {}
+
+int MemCpyCommand::process(int line, Context *context) {
+    if (underflows(context->data, 3)) {
+        return trap(eTrap::StackUnderflow);
+    }
+    int count = context->data.peek(0);
+    int source = context->data.peek(1);
+    int destination = context->data.peek(2);
+    if (not in_memory(context, source, count) || not in_memory(context, destination, count)) {
+        return trap(eTrap::BadAddress);
+    }
+    Kernels::copy(context->memory + destination, context->memory + source, count);
+    context->data.pop();
+    context->data.pop();
+    context->data.pop();
+    return line + 1;
+}
+
+void MemCpyCommand::setup(int line) {}
+
+int MemSetCommand::process(int line, Context *context) {
+    if (underflows(context->data, 3)) {
+        return trap(eTrap::StackUnderflow);
+    }
+    int count = context->data.peek(0);
+    int value = context->data.peek(1);
+    int destination = context->data.peek(2);
+    if (not in_memory(context, destination, count)) {
+        return trap(eTrap::BadAddress);
+    }
+    Kernels::fill(context->memory + destination, value, count);
+    context->data.pop();
+    context->data.pop();
+    context->data.pop();
+    return line + 1;
+}
+
+void MemSetCommand::setup(int line) {}
+
+int MemSumCommand::process(int line, Context *context) {
+    if (underflows(context->data, 2)) {
+        return trap(eTrap::StackUnderflow);
+    }
+    int count = context->data.peek(0);
+    int address = context->data.peek(1);
+    if (not in_memory(context, address, count)) {
+        return trap(eTrap::BadAddress);
+    }
+    context->data.pop();
+    context->data.top() = Kernels::sum(context->memory + address, count);
+    return line + 1;
+}
+
+void MemSumCommand::setup(int line) {}
\ No newline at end of file
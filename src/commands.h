@@ -5,19 +5,22 @@
 #include <string>
 #include <memory>
 #include <map>
+#include <array>
 
-#include "stack.h"
+#include "context.h"
 #include "data.h"
+#include "trap.h"
 
 
-using shared_stack = std::shared_ptr<CommandStack>;
-
-enum class eCommands {
+enum class eCommands : uint8_t {
     Begin = 0, End, Push, Pop, PushR, PopR,
     Add, Sub, Mul, Div, In, Out, Label,
-    Jump, JumpE, JumpNE, JumpG, JumpGE, JumpL, JumpLE, Call, Ret, Blank
+    Jump, JumpE, JumpNE, JumpG, JumpGE, JumpL, JumpLE, Call, Ret, Blank, Break, Send, Recv, Spawn, Join,
+    Memory, Load, Store, LoadR, StoreR, MemCpy, MemSet, MemSum
 };
 
+constexpr size_t command_count = static_cast<size_t>(eCommands::MemSum) + 1;
+
 static std::map<eCommands, std::string> command_name{
         {eCommands::Begin,  "BEGIN"},
         {eCommands::End,    "END"},
@@ -41,7 +44,20 @@ static std::map<eCommands, std::string> command_name{
         {eCommands::JumpLE, "JBE"},
         {eCommands::Call,   "CALL"},
         {eCommands::Ret,    "RET"},
-        {eCommands::Blank,  "BLANK"}
+        {eCommands::Blank,  "BLANK"},
+        {eCommands::Break,  "BREAK"},
+        {eCommands::Send,   "SEND"},
+        {eCommands::Recv,   "RECV"},
+        {eCommands::Spawn,  "SPAWN"},
+        {eCommands::Join,   "JOIN"},
+        {eCommands::Memory, "MEMORY"},
+        {eCommands::Load,   "LOAD"},
+        {eCommands::Store,  "STORE"},
+        {eCommands::LoadR,  "LOADR"},
+        {eCommands::StoreR, "STORER"},
+        {eCommands::MemCpy, "MEMCPY"},
+        {eCommands::MemSet, "MEMSET"},
+        {eCommands::MemSum, "MEMSUM"}
 };
 
 template<typename T>
@@ -70,58 +86,81 @@ class BaseCommand {
 public:
     virtual eCommands name() = 0;
 
-    virtual int run(std::string, int, shared_stack) = 0;
+    virtual int run(std::string, int, Context *) = 0;
+
+    virtual int execute(int32_t, int, Context *) = 0;
 
     virtual void configure(std::string, int) = 0;
 
+    virtual int32_t encode(const std::string &) = 0;
+
     virtual void clear() {};
+
+protected:
+    static int raise(int, int32_t);
 };
 
 class BaseParamLessCommand : public BaseCommand {
 public:
-    virtual int process(int, shared_stack) = 0;
+    virtual int process(int, Context *) = 0;
 
     virtual void setup(int) = 0;
 
-    int run(std::string, int, shared_stack) override;
+    int run(std::string, int, Context *) override;
+
+    int execute(int32_t, int, Context *) override;
 
     void configure(std::string, int) override;
+
+    int32_t encode(const std::string &) override;
 };
 
 class BaseIntegerCommand : public BaseCommand {
 private:
-    static int clear_param(std::string &, int);
+    static int clear_param(const std::string &, int);
 
 public:
-    virtual int process(int, int, shared_stack) = 0;
+    virtual int process(int, int, Context *) = 0;
 
     virtual void setup(int, int) = 0;
 
-    int run(std::string, int, shared_stack) override;
+    int run(std::string, int, Context *) override;
+
+    int execute(int32_t, int, Context *) override;
 
     void configure(std::string, int) override;
+
+    int32_t encode(const std::string &) override;
 };
 
 class BaseRegisterCommand : public BaseCommand {
 public:
-    virtual int process(RegisterType &, int, shared_stack) = 0;
+    virtual int process(int, int, Context *) = 0;
 
     virtual void setup(RegisterType &, int) = 0;
 
-    int run(std::string, int, shared_stack) override;
+    int run(std::string, int, Context *) override;
+
+    int execute(int32_t, int, Context *) override;
 
     void configure(std::string, int) override;
+
+    int32_t encode(const std::string &) override;
 };
 
 class BaseLabelCommand : public BaseCommand {
 public:
-    virtual int process(LabelType &, int, shared_stack) = 0;
+    virtual int process(int, int, Context *) = 0;
 
     virtual void setup(LabelType &, int) = 0;
 
-    int run(std::string, int, shared_stack) override;
+    int run(std::string, int, Context *) override;
+
+    int execute(int32_t, int, Context *) override;
 
     void configure(std::string, int) override;
+
+    int32_t encode(const std::string &) override;
 };
 
 class BeginCommand : public BaseParamLessCommand {
@@ -130,7 +169,7 @@ private:
 public:
     eCommands name() override { return eCommands::Begin; };
 
-    int process(int, shared_stack) override;
+    int process(int, Context *) override;
 
     void setup(int) override;
 
@@ -145,7 +184,7 @@ private:
 public:
     eCommands name() override { return eCommands::End; };
 
-    int process(int, shared_stack) override;
+    int process(int, Context *) override;
 
     void setup(int) override;
 
@@ -158,7 +197,7 @@ class PushCommand : public BaseIntegerCommand {
 public:
     eCommands name() override { return eCommands::Push; };
 
-    int process(int, int, shared_stack) override;
+    int process(int, int, Context *) override;
 
     void setup(int, int) override;
 };
@@ -167,7 +206,7 @@ class PopCommand : public BaseParamLessCommand {
 public:
     eCommands name() override { return eCommands::Pop; };
 
-    int process(int, shared_stack) override;
+    int process(int, Context *) override;
 
     void setup(int) override;
 };
@@ -176,7 +215,7 @@ class PushRCommand : public BaseRegisterCommand {
 public:
     eCommands name() override { return eCommands::PushR; };
 
-    int process(RegisterType &, int, shared_stack) override;
+    int process(int, int, Context *) override;
 
     void setup(RegisterType &, int) override;
 };
@@ -185,7 +224,7 @@ class PopRCommand : public BaseRegisterCommand {
 public:
     eCommands name() override { return eCommands::PopR; };
 
-    int process(RegisterType &, int, shared_stack) override;
+    int process(int, int, Context *) override;
 
     void setup(RegisterType &, int) override;
 };
@@ -194,7 +233,7 @@ class AddCommand : public BaseParamLessCommand {
 public:
     eCommands name() override { return eCommands::Add; }
 
-    int process(int, shared_stack) override;
+    int process(int, Context *) override;
 
     void setup(int) override;
 };
@@ -203,7 +242,7 @@ class SubCommand : public BaseParamLessCommand {
 public:
     eCommands name() override { return eCommands::Sub; }
 
-    int process(int, shared_stack) override;
+    int process(int, Context *) override;
 
     void setup(int) override;
 };
@@ -212,7 +251,7 @@ class MulCommand : public BaseParamLessCommand {
 public:
     eCommands name() override { return eCommands::Mul; }
 
-    int process(int, shared_stack) override;
+    int process(int, Context *) override;
 
     void setup(int) override;
 };
@@ -221,7 +260,7 @@ class DivCommand : public BaseParamLessCommand {
 public:
     eCommands name() override { return eCommands::Div; }
 
-    int process(int, shared_stack) override;
+    int process(int, Context *) override;
 
     void setup(int) override;
 };
@@ -230,7 +269,7 @@ class InCommand : public BaseParamLessCommand {
 public:
     eCommands name() override { return eCommands::In; }
 
-    int process(int, shared_stack) override;
+    int process(int, Context *) override;
 
     void setup(int) override;
 };
@@ -239,16 +278,34 @@ class OutCommand : public BaseParamLessCommand {
 public:
     eCommands name() override { return eCommands::Out; }
 
-    int process(int, shared_stack) override;
+    int process(int, Context *) override;
 
     void setup(int) override;
 };
 
+class SendCommand : public BaseIntegerCommand {
+public:
+    eCommands name() override { return eCommands::Send; }
+
+    int process(int, int, Context *) override;
+
+    void setup(int, int) override;
+};
+
+class RecvCommand : public BaseIntegerCommand {
+public:
+    eCommands name() override { return eCommands::Recv; }
+
+    int process(int, int, Context *) override;
+
+    void setup(int, int) override;
+};
+
 class LabelCommand : public BaseLabelCommand {
 public:
     eCommands name() override { return eCommands::Label; }
 
-    int process(LabelType &, int, shared_stack) override;
+    int process(int, int, Context *) override;
 
     void setup(LabelType &, int) override;
 };
@@ -257,7 +314,7 @@ class JumpCommand : public BaseLabelCommand {
 public:
     eCommands name() override { return eCommands::Jump; }
 
-    int process(LabelType &, int, shared_stack) override;
+    int process(int, int, Context *) override;
 
     void setup(LabelType &, int) override;
 };
@@ -266,7 +323,7 @@ class JumpEqualCommand : public BaseLabelCommand {
 public:
     eCommands name() override { return eCommands::JumpE; }
 
-    int process(LabelType &, int, shared_stack) override;
+    int process(int, int, Context *) override;
 
     void setup(LabelType &, int) override;
 };
@@ -275,7 +332,7 @@ class JumpNotEqualCommand : public BaseLabelCommand {
 public:
     eCommands name() override { return eCommands::JumpNE; }
 
-    int process(LabelType &, int, shared_stack) override;
+    int process(int, int, Context *) override;
 
     void setup(LabelType &, int) override;
 };
@@ -284,7 +341,7 @@ class JumpGreaterCommand : public BaseLabelCommand {
 public:
     eCommands name() override { return eCommands::JumpG; }
 
-    int process(LabelType &, int, shared_stack) override;
+    int process(int, int, Context *) override;
 
     void setup(LabelType &, int) override;
 };
@@ -293,7 +350,7 @@ class JumpGreaterOrEqualCommand : public BaseLabelCommand {
 public:
     eCommands name() override { return eCommands::JumpGE; }
 
-    int process(LabelType &, int, shared_stack) override;
+    int process(int, int, Context *) override;
 
     void setup(LabelType &, int) override;
 };
@@ -302,7 +359,7 @@ class JumpLessCommand : public BaseLabelCommand {
 public:
     eCommands name() override { return eCommands::JumpL; }
 
-    int process(LabelType &, int, shared_stack) override;
+    int process(int, int, Context *) override;
 
     void setup(LabelType &, int) override;
 };
@@ -311,7 +368,7 @@ class JumpLessOrEqualCommand : public BaseLabelCommand {
 public:
     eCommands name() override { return eCommands::JumpLE; }
 
-    int process(LabelType &, int, shared_stack) override;
+    int process(int, int, Context *) override;
 
     void setup(LabelType &, int) override;
 };
@@ -321,7 +378,7 @@ class CallCommand : public BaseLabelCommand {
 public:
     eCommands name() override { return eCommands::Call; }
 
-    int process(LabelType &, int, shared_stack) override;
+    int process(int, int, Context *) override;
 
     void setup(LabelType &, int) override;
 };
@@ -330,7 +387,104 @@ class RetCommand : public BaseParamLessCommand {
 public:
     eCommands name() override { return eCommands::Ret; }
 
-    int process(int, shared_stack) override;
+    int process(int, Context *) override;
+
+    void setup(int) override;
+};
+
+class SpawnCommand : public BaseLabelCommand {
+public:
+    eCommands name() override { return eCommands::Spawn; }
+
+    int process(int, int, Context *) override;
+
+    void setup(LabelType &, int) override;
+};
+
+class JoinCommand : public BaseParamLessCommand {
+public:
+    eCommands name() override { return eCommands::Join; }
+
+    int process(int, Context *) override;
+
+    void setup(int) override;
+};
+
+class MemoryCommand : public BaseIntegerCommand {
+private:
+    int size_ = 0;
+    int line_ = -1;
+public:
+    eCommands name() override { return eCommands::Memory; }
+
+    int process(int, int, Context *) override;
+
+    void setup(int, int) override;
+
+    void clear() override;
+
+    [[nodiscard]] int get_size() const { return size_; }
+};
+
+class LoadCommand : public BaseParamLessCommand {
+public:
+    eCommands name() override { return eCommands::Load; }
+
+    int process(int, Context *) override;
+
+    void setup(int) override;
+};
+
+class StoreCommand : public BaseParamLessCommand {
+public:
+    eCommands name() override { return eCommands::Store; }
+
+    int process(int, Context *) override;
+
+    void setup(int) override;
+};
+
+class LoadRCommand : public BaseRegisterCommand {
+public:
+    eCommands name() override { return eCommands::LoadR; }
+
+    int process(int, int, Context *) override;
+
+    void setup(RegisterType &, int) override;
+};
+
+class StoreRCommand : public BaseRegisterCommand {
+public:
+    eCommands name() override { return eCommands::StoreR; }
+
+    int process(int, int, Context *) override;
+
+    void setup(RegisterType &, int) override;
+};
+
+class MemCpyCommand : public BaseParamLessCommand {
+public:
+    eCommands name() override { return eCommands::MemCpy; }
+
+    int process(int, Context *) override;
+
+    void setup(int) override;
+};
+
+class MemSetCommand : public BaseParamLessCommand {
+public:
+    eCommands name() override { return eCommands::MemSet; }
+
+    int process(int, Context *) override;
+
+    void setup(int) override;
+};
+
+class MemSumCommand : public BaseParamLessCommand {
+public:
+    eCommands name() override { return eCommands::MemSum; }
+
+    int process(int, Context *) override;
 
     void setup(int) override;
 };
@@ -339,9 +493,27 @@ class BlankCommand : public BaseCommand {
 public:
     eCommands name() override { return eCommands::Blank; }
 
-    int run(std::string, int line, shared_stack) override { return line + 1; }
+    int run(std::string, int line, Context *) override { return line + 1; }
+
+    int execute(int32_t, int line, Context *) override { return line + 1; }
+
+    void configure(std::string, int) override {}
+
+    int32_t encode(const std::string &) override { return 0; }
+};
+
+
+class BreakCommand : public BaseCommand {
+public:
+    eCommands name() override { return eCommands::Break; }
+
+    int run(std::string, int, Context *) override { return trap(eTrap::Breakpoint); }
+
+    int execute(int32_t, int, Context *) override { return trap(eTrap::Breakpoint); }
 
     void configure(std::string, int) override {}
+
+    int32_t encode(const std::string &) override { return 0; }
 };
 
 
@@ -357,6 +529,8 @@ using Mul = Singleton<MulCommand>;
 using Div = Singleton<DivCommand>;
 using In = Singleton<InCommand>;
 using Out = Singleton<OutCommand>;
+using Send = Singleton<SendCommand>;
+using Recv = Singleton<RecvCommand>;
 
 using Label = Singleton<LabelCommand>;
 
@@ -371,8 +545,22 @@ using JumpLE = Singleton<JumpLessOrEqualCommand>;
 using Call = Singleton<CallCommand>;
 using Ret = Singleton<RetCommand>;
 
+using Spawn = Singleton<SpawnCommand>;
+using Join = Singleton<JoinCommand>;
+
+using Memory = Singleton<MemoryCommand>;
+using Load = Singleton<LoadCommand>;
+using Store = Singleton<StoreCommand>;
+using LoadR = Singleton<LoadRCommand>;
+using StoreR = Singleton<StoreRCommand>;
+using MemCpy = Singleton<MemCpyCommand>;
+using MemSet = Singleton<MemSetCommand>;
+using MemSum = Singleton<MemSumCommand>;
+
 using Blank = Singleton<BlankCommand>;
 
+using Break = Singleton<BreakCommand>;
+
 static std::map<std::string, BaseCommand &> command_by_name = {
         {"BEGIN", Begin::instance()},
         {"BEG",   Begin::instance()},
@@ -387,6 +575,8 @@ static std::map<std::string, BaseCommand &> command_by_name = {
         {"DIV",   Div::instance()},
         {"IN",    In::instance()},
         {"OUT",   Out::instance()},
+        {"SEND",  Send::instance()},
+        {"RECV",  Recv::instance()},
         {"LABEL", Label::instance()},
         {"JMP",   Jump::instance()},
         {"JEQ",   JumpE::instance()},
@@ -397,5 +587,54 @@ static std::map<std::string, BaseCommand &> command_by_name = {
         {"JBE",   JumpLE::instance()},
         {"CALL",  Call::instance()},
         {"RET",   Ret::instance()},
+        {"SPAWN", Spawn::instance()},
+        {"JOIN",  Join::instance()},
+        {"MEMORY", Memory::instance()},
+        {"LOAD",  Load::instance()},
+        {"STORE", Store::instance()},
+        {"LOADR", LoadR::instance()},
+        {"STORER", StoreR::instance()},
+        {"MEMCPY", MemCpy::instance()},
+        {"MEMSET", MemSet::instance()},
+        {"MEMSUM", MemSum::instance()},
         {"BLANK", Blank::instance()}
+};
+
+static const std::array<BaseCommand *, command_count> command_by_id = {
+        &Begin::instance(),
+        &End::instance(),
+        &Push::instance(),
+        &Pop::instance(),
+        &PushR::instance(),
+        &PopR::instance(),
+        &Add::instance(),
+        &Sub::instance(),
+        &Mul::instance(),
+        &Div::instance(),
+        &In::instance(),
+        &Out::instance(),
+        &Label::instance(),
+        &Jump::instance(),
+        &JumpE::instance(),
+        &JumpNE::instance(),
+        &JumpG::instance(),
+        &JumpGE::instance(),
+        &JumpL::instance(),
+        &JumpLE::instance(),
+        &Call::instance(),
+        &Ret::instance(),
+        &Blank::instance(),
+        &Break::instance(),
+        &Send::instance(),
+        &Recv::instance(),
+        &Spawn::instance(),
+        &Join::instance(),
+        &Memory::instance(),
+        &Load::instance(),
+        &Store::instance(),
+        &LoadR::instance(),
+        &StoreR::instance(),
+        &MemCpy::instance(),
+        &MemSet::instance(),
+        &MemSum::instance()
 };
\ No newline at end of file
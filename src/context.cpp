@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <charconv>
+#include <iostream>
+#include <new>
+#include "context.h"
+#include "journal.h"
+
+#ifdef EMU_GUARDED_STACKS
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#endif
+
+namespace {
+    size_t align_up(size_t value, size_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+#ifdef EMU_GUARDED_STACKS
+    // Guarded stacks are reserved without backing, so unbounded ones can afford the depth pages are touched to
+    constexpr size_t unbounded_capacity = 1u << 26;
+#else
+    constexpr size_t unbounded_capacity = Context::default_capacity;
+#endif
+
+    size_t capacity_of(int32_t hint) {
+        return hint < 0 ? unbounded_capacity : std::max<size_t>(hint, 16);
+    }
+}
+
+Context::Pointer Context::create(const StackHints &hints) {
+    size_t registers = RegisterType::available.size();
+#ifdef EMU_GUARDED_STACKS
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t guard = page;
+#else
+    size_t page = 64;
+    size_t guard = 0;
+#endif
+    size_t header = align_up(sizeof(Context) + registers * sizeof(int) + output_capacity, page);
+    size_t data_size = align_up(capacity_of(hints.data) * sizeof(int), page);
+    size_t call_size = align_up(capacity_of(hints.call) * sizeof(int), page);
+    size_t data_offset = header + guard;
+    size_t memory_size = align_up(static_cast<size_t>(std::max(hints.memory, 0)) * sizeof(int), page);
+    size_t call_offset = data_offset + data_size + 2 * guard;
+    size_t memory_offset = call_offset + call_size + guard;
+    size_t total = memory_offset + memory_size;
+
+#ifdef EMU_GUARDED_STACKS
+    void *region = mmap(nullptr, total, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (region == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    auto *arena = static_cast<char *>(region);
+    if (mprotect(arena, header, PROT_READ | PROT_WRITE) != 0 ||
+        mprotect(arena + data_offset, data_size, PROT_READ | PROT_WRITE) != 0 ||
+        mprotect(arena + call_offset, call_size, PROT_READ | PROT_WRITE) != 0 ||
+        (memory_size > 0 && mprotect(arena + memory_offset, memory_size, PROT_READ | PROT_WRITE) != 0)) {
+        munmap(arena, total);
+        throw std::bad_alloc();
+    }
+#else
+    auto *arena = static_cast<char *>(::operator new(total, std::align_val_t(page)));
+#endif
+
+    Pointer context(new(arena) Context());
+    context->arena_size_ = total;
+    context->registers = reinterpret_cast<int *>(arena + sizeof(Context));
+    std::fill_n(context->registers, registers, 0);
+    context->output_ = reinterpret_cast<char *>(context->registers + registers);
+    context->data = {reinterpret_cast<int *>(arena + data_offset), static_cast<uint32_t>(data_size / sizeof(int)),
+                     guard};
+    context->call = {reinterpret_cast<int *>(arena + call_offset), static_cast<uint32_t>(call_size / sizeof(int)),
+                     guard};
+    // Linear memory is bounds checked by the commands, so it needs no guard page of its own
+    context->memory = reinterpret_cast<int *>(arena + memory_offset);
+    context->memory_size = static_cast<uint32_t>(std::max(hints.memory, 0));
+    std::fill_n(context->memory, context->memory_size, 0);
+    return context;
+}
+
+void Context::Deleter::operator()(Context *context) const {
+    size_t size = context->arena_size_;
+    context->~Context();
+#ifdef EMU_GUARDED_STACKS
+    munmap(context, size);
+#else
+    ::operator delete(context, size, std::align_val_t(64));
+#endif
+}
+
+void Context::write(int value) {
+    if (output_size_ + 16 > output_capacity) {
+        flush();
+    }
+    auto [end, error] = std::to_chars(output_ + output_size_, output_ + output_capacity, value);
+    *end++ = '\n';
+    output_size_ = static_cast<uint32_t>(end - output_);
+    // VMs sharing a journal interleave their output value by value in the recorded order
+    if (journal && journal->ordered()) {
+        flush();
+    }
+}
+
+int Context::read() {
+    flush();
+    auto prompt = [] { std::cout << "Input number: "; };
+    auto scan = [&prompt] {
+        int value = 0;
+        prompt();
+        std::cin >> value;
+        return value;
+    };
+    return journal ? journal->input(node, prompt, scan) : scan();
+}
+
+void Context::flush() {
+    if (output_size_ == 0) {
+        return;
+    }
+    auto write = [this] {
+        std::cout.write(output_, output_size_);
+        std::cout.flush();
+    };
+    if (journal) {
+        journal->output(node, write);
+    } else {
+        write();
+    }
+    output_size_ = 0;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "data.h"
+
+#ifdef EMU_GUARDED_STACKS
+constexpr bool guarded_stacks = true;
+#else
+constexpr bool guarded_stacks = false;
+#endif
+
+struct StackHints {
+    int32_t data = -1;
+    int32_t call = -1;
+    int32_t memory = 0;
+};
+
+template<class T>
+class ArenaStack {
+public:
+    ArenaStack() = default;
+
+    ArenaStack(T *base, uint32_t capacity, size_t guard) : base_(base), top_(base), limit_(base + capacity),
+                                                            guard_(guard) {}
+
+    void push(const T &value) { *top_++ = value; }
+
+    T &top() { return top_[-1]; }
+
+    T &peek(uint32_t depth) { return top_[-1 - static_cast<ptrdiff_t>(depth)]; }
+
+    T &at(uint32_t index) { return base_[index]; }
+
+    void pop() {
+        if constexpr (guarded_stacks) {
+            static_cast<void>(*static_cast<volatile T *>(--top_));
+        } else {
+            --top_;
+        }
+    }
+
+    void clear() { top_ = base_; }
+
+    [[nodiscard]] uint32_t size() const { return static_cast<uint32_t>(top_ - base_); }
+
+    [[nodiscard]] uint32_t capacity() const { return static_cast<uint32_t>(limit_ - base_); }
+
+    [[nodiscard]] bool empty() const { return top_ == base_; }
+
+    [[nodiscard]] bool full() const { return top_ == limit_; }
+
+    [[nodiscard]] bool below(const void *address) const {
+        auto *pointer = static_cast<const char *>(address);
+        auto *base = reinterpret_cast<const char *>(base_);
+        return base - guard_ <= pointer && pointer < base;
+    }
+
+    [[nodiscard]] bool above(const void *address) const {
+        auto *pointer = static_cast<const char *>(address);
+        auto *limit = reinterpret_cast<const char *>(limit_);
+        return limit <= pointer && pointer < limit + guard_;
+    }
+
+private:
+    T *base_ = nullptr;
+    T *top_ = nullptr;
+    T *limit_ = nullptr;
+    size_t guard_ = 0;
+};
+
+class Memo;
+
+class Channels;
+
+class Scheduler;
+
+class Journal;
+
+class Context {
+public:
+    static constexpr uint32_t default_capacity = 1u << 20;
+    static constexpr uint32_t output_capacity = 4096;
+    static constexpr int32_t memory_limit = 1 << 28;
+
+    struct Deleter {
+        void operator()(Context *) const;
+    };
+
+    using Pointer = std::unique_ptr<Context, Deleter>;
+
+    static Pointer create(const StackHints &hints = {});
+
+    Context(const Context &) = delete;
+
+    Context &operator=(const Context &) = delete;
+
+    ArenaStack<int> data;
+    ArenaStack<int> call;
+    int *registers = nullptr;
+    int *memory = nullptr;
+    uint32_t memory_size = 0;
+    int pc = -1;
+    Memo *memo = nullptr;
+    Channels *channels = nullptr;
+    Scheduler *scheduler = nullptr;
+    uint32_t depth = 0;
+    Journal *journal = nullptr;
+    int node = 0;
+
+    void write(int value);
+
+    int read();
+
+    void flush();
+
+private:
+    Context() = default;
+
+    ~Context() = default;
+
+    char *output_ = nullptr;
+    uint32_t output_size_ = 0;
+    size_t arena_size_ = 0;
+};
@@ -0,0 +1,182 @@
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include "cpu.h"
+
+namespace {
+    const std::vector<std::string> shapes = {"straight", "labels", "calls", "fanin"};
+
+    // Emits a program of roughly `size` instructions in one of the shapes
+    void generate(const std::string &shape, uint64_t size, std::ostream &out) {
+        if (shape == "straight") {
+            out << "beg\npush 1\n";
+            for (uint64_t i = 2; i + 2 < size; i += 2) {
+                out << "push " << i % 1000 << "\n" << (i % 4 == 0 ? "add" : "mul") << "\n";
+            }
+            out << "out\nend\n";
+        } else if (shape == "labels") {
+            // Every label is a jump target whose block feeds the output, so optimisation keeps them all
+            out << "beg\npush 0\npopr ax\njmp L0\n";
+            uint64_t i = 0;
+            for (; i + 10 < size; i += 6) {
+                out << "L" << i << ":\npushr ax\npush " << i % 1000 << "\nadd\npopr ax\njmp L" << i + 6 << "\n";
+            }
+            out << "L" << i << ":\npushr ax\nout\nend\n";
+        } else if (shape == "calls") {
+            uint64_t depth = std::max<uint64_t>(size / 3, 1);
+            for (uint64_t i = 0; i < depth; i++) {
+                out << "f" << i << ":\n";
+                if (i + 1 < depth) {
+                    out << "call f" << i + 1 << "\n";
+                }
+                out << "ret\n";
+            }
+            out << "beg\ncall f0\nend\n";
+        } else if (shape == "fanin") {
+            out << "beg\n";
+            for (uint64_t i = 0; i + 5 < size; i += 4) {
+                out << "push " << i % 1000 << "\npushr ax\njeq hub\npop\n";
+            }
+            out << "hub:\nend\n";
+        } else {
+            throw std::invalid_argument("Unknown shape \"" + shape + "\"");
+        }
+    }
+
+    struct Sample {
+        double seconds = -1;
+        long peak_kb = -1;
+    };
+
+    // Measures an action in a child process, so its peak memory is not shadowed by earlier measurements
+    Sample measure(const std::function<void()> &action) {
+        int pipe_fds[2];
+        if (pipe(pipe_fds) != 0) {
+            throw std::runtime_error("Can not create pipe");
+        }
+        std::cout.flush();
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(pipe_fds[0]);
+            auto start = std::chrono::steady_clock::now();
+            action();
+            Sample sample;
+            sample.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            rusage usage{};
+            getrusage(RUSAGE_SELF, &usage);
+            sample.peak_kb = usage.ru_maxrss;
+            if (write(pipe_fds[1], &sample, sizeof(sample)) != sizeof(sample)) {
+                _exit(1);
+            }
+            _exit(0);
+        }
+        close(pipe_fds[1]);
+        Sample sample;
+        if (read(pipe_fds[0], &sample, sizeof(sample)) != sizeof(sample)) {
+            sample = {};
+        }
+        close(pipe_fds[0]);
+        waitpid(pid, nullptr, 0);
+        return sample;
+    }
+
+    int bench(uint64_t min_size, uint64_t max_size, const std::vector<std::string> &selected,
+              const std::string &directory, double tolerance, std::ostream &out) {
+        std::filesystem::create_directories(directory);
+        out << "shape,instructions,parse_ms,build_ms,load_ms,binary_bytes,build_peak_kb,load_peak_kb" << std::endl;
+        bool superlinear = false;
+        for (auto &shape: selected) {
+            std::map<uint64_t, double> cost;
+            for (uint64_t size = min_size; size <= max_size; size *= 10) {
+                auto source = directory + "/" + shape + "_" + std::to_string(size) + ".txt";
+                std::ofstream file(source);
+                generate(shape, size, file);
+                file.close();
+                auto parse = measure([&] {
+                    Parser parser;
+                    parser.parse(source);
+                    Preprocessor::clear();
+                });
+                auto build = measure([&] { Preprocessor().build(source, source); });
+                auto load = measure([&] { Preprocessor().load(source + ".emu"); });
+                auto bytes = std::filesystem::exists(source + ".emu") ? std::filesystem::file_size(source + ".emu") : 0;
+                out << shape << ',' << size << ',' << parse.seconds * 1000 << ',' << build.seconds * 1000 << ','
+                    << load.seconds * 1000 << ',' << bytes << ',' << build.peak_kb << ',' << load.peak_kb << std::endl;
+                cost[size] = (build.seconds + load.seconds) / static_cast<double>(size);
+            }
+            // Per-instruction cost is compared from the 10K point on, below that fixed costs dominate
+            auto base = cost.lower_bound(std::min<uint64_t>(10000, max_size));
+            if (base != cost.end() && cost.rbegin()->second > base->second * tolerance) {
+                std::cerr << "Super-linear " << shape << ": " << cost.rbegin()->second * 1e9 << " ns per instruction at "
+                          << cost.rbegin()->first << ", " << base->second * 1e9 << " at " << base->first << std::endl;
+                superlinear = true;
+            }
+        }
+        return superlinear ? 1 : 0;
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 5 && std::string(argv[1]) == "generate") {
+        std::ofstream file(argv[4]);
+        if (not file.is_open()) {
+            std::cerr << "Can not create file \"" << argv[4] << "\"" << std::endl;
+            return 1;
+        }
+        try {
+            generate(argv[2], std::stoull(argv[3]), file);
+        } catch (std::invalid_argument &e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    if (argc >= 2 && std::string(argv[1]) == "bench") {
+        uint64_t min_size = 1000;
+        uint64_t max_size = 1000000;
+        double tolerance = 4;
+        std::vector<std::string> selected = shapes;
+        std::string directory = "corpus";
+        std::string csv;
+        for (int i = 2; i < argc; i++) {
+            std::string option = argv[i];
+            auto value = option.substr(option.find('=') + 1);
+            if (option.starts_with("--min=")) {
+                min_size = std::stoull(value);
+            } else if (option.starts_with("--max=")) {
+                max_size = std::stoull(value);
+            } else if (option.starts_with("--tolerance=")) {
+                tolerance = std::stod(value);
+            } else if (option.starts_with("--shape=")) {
+                selected = {value};
+            } else if (option.starts_with("--dir=")) {
+                directory = value;
+            } else if (option.starts_with("--csv=")) {
+                csv = value;
+            } else {
+                std::cerr << "Unknown option \"" << option << "\"" << std::endl;
+                return 1;
+            }
+        }
+        if (std::find(shapes.begin(), shapes.end(), selected.front()) == shapes.end()) {
+            std::cerr << "Unknown shape \"" << selected.front() << "\"" << std::endl;
+            return 1;
+        }
+        if (csv.empty()) {
+            return bench(min_size, max_size, selected, directory, tolerance, std::cout);
+        }
+        std::ofstream file(csv);
+        return bench(min_size, max_size, selected, directory, tolerance, file);
+    }
+    std::cerr << "Usage: Corpus generate <straight|labels|calls|fanin> <instructions> <file>\n"
+                 "       Corpus bench [--min=N] [--max=N] [--shape=S] [--dir=D] [--csv=F] [--tolerance=X]" << std::endl;
+    return 1;
+}
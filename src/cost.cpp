@@ -0,0 +1,124 @@
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include "cost.h"
+#include "exc.h"
+
+CostModel::CostModel() {
+    cycles.fill(1);
+    for (auto command: {eCommands::Begin, eCommands::Label, eCommands::Blank}) {
+        cycles[static_cast<size_t>(command)] = 0;
+    }
+}
+
+CostModel CostModel::read(std::istream &in) {
+    CostModel model;
+    std::optional<uint64_t> fallback;
+    std::map<eCommands, uint64_t> explicit_cycles;
+    std::string line;
+    for (int line_number = 1; std::getline(in, line); line_number++) {
+        std::stringstream stream(line.substr(0, line.find("//")));
+        std::string key;
+        uint64_t value;
+        if (not(stream >> key)) {
+            continue;
+        }
+        if (not(stream >> value)) {
+            throw InvalidArgumentException("Expected \"<opcode or key> <cycles>\"", line_number);
+        }
+        if (key == "default") {
+            fallback = value;
+        } else if (key == "taken") {
+            model.taken = value;
+        } else if (key == "call") {
+            model.call = value;
+        } else if (key == "ret") {
+            model.ret = value;
+        } else if (key == "cache") {
+            model.cache = static_cast<uint32_t>(value);
+        } else if (key == "spill") {
+            model.spill = value;
+        } else {
+            auto it = std::find_if(command_name.begin(), command_name.end(), [&key](auto &entry) {
+                return entry.second == key;
+            });
+            if (it == command_name.end()) {
+                throw InvalidArgumentException("Unknown opcode \"" + key + "\"", line_number);
+            }
+            explicit_cycles[it->first] = value;
+        }
+    }
+    if (fallback) {
+        for (size_t i = 0; i < command_count; i++) {
+            if (model.cycles[i] != 0) {
+                model.cycles[i] = *fallback;
+            }
+        }
+    }
+    for (auto [command, value]: explicit_cycles) {
+        model.cycles[static_cast<size_t>(command)] = value;
+    }
+    return model;
+}
+
+CostModel CostModel::load(const std::string &file_name) {
+    std::ifstream file(file_name);
+    if (not file.is_open()) {
+        throw std::runtime_error("File is closed");
+    }
+    return read(file);
+}
+
+CycleCounter::CycleCounter(const CostModel &model, size_t program_size) : model_(model),
+                                                                          lines_(program_size, 0),
+                                                                          executed_(program_size, 0) {
+    frames_.push_back({&subroutines_[-1], 0});
+    frames_.back().subroutine->calls = 1;
+    frames_.back().subroutine->active = 1;
+}
+
+void CycleCounter::enter(int entry) {
+    auto *subroutine = &subroutines_[entry];
+    subroutine->calls++;
+    subroutine->active++;
+    frames_.push_back({subroutine, total_});
+}
+
+void CycleCounter::leave() {
+    auto frame = frames_.back();
+    frames_.pop_back();
+    // Recursive activations are already inside the outermost one
+    if (--frame.subroutine->active == 0) {
+        frame.subroutine->total += total_ - frame.start;
+    }
+}
+
+void CycleCounter::report(std::ostream &out, const std::function<int(int)> &line_of,
+                          const std::function<std::string(int)> &name_of) const {
+    out << "cycles: " << total_ << " in " << instructions_ << " instructions" << std::endl;
+    std::map<int, std::pair<uint64_t, uint64_t>> by_line;
+    for (int pc = 0; pc < lines_.size(); pc++) {
+        if (executed_[pc] > 0) {
+            int line = line_of(pc);
+            auto &[cycles, executed] = by_line[line == -1 ? -pc - 1 : line];
+            cycles += lines_[pc];
+            executed += executed_[pc];
+        }
+    }
+    for (auto &[line, counts]: by_line) {
+        out << "cycles: " << (line < 0 ? "instruction " + std::to_string(-line - 1) : "line " + std::to_string(line))
+            << ' ' << counts.first << " in " << counts.second << std::endl;
+    }
+    for (auto &[entry, subroutine]: subroutines_) {
+        // Frames still open at the end, like the main program, run to the last instruction
+        uint64_t total = subroutine.total;
+        for (auto &frame: frames_) {
+            if (frame.subroutine == &subroutine) {
+                total = subroutine.total + total_ - frame.start;
+                break;
+            }
+        }
+        out << "cycles: subroutine " << (entry == -1 ? "main" : name_of(entry)) << ' ' << subroutine.self
+            << " self, " << total << " total, " << subroutine.calls << " calls" << std::endl;
+    }
+}
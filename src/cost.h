@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "commands.h"
+
+struct CostModel {
+    std::array<uint64_t, command_count> cycles{};
+    uint64_t taken = 0;
+    uint64_t call = 0;
+    uint64_t ret = 0;
+    uint32_t cache = 0;
+    uint64_t spill = 0;
+
+    CostModel();
+
+    static CostModel read(std::istream &);
+
+    static CostModel load(const std::string &);
+};
+
+class CycleCounter {
+public:
+    CycleCounter(const CostModel &model, size_t program_size);
+
+    void account(eCommands command, int32_t operand, int line, int next, uint32_t depth) {
+        uint64_t cost = model_.cycles[static_cast<size_t>(command)];
+        if (command == eCommands::Call) {
+            cost += model_.call;
+        } else if (command == eCommands::Ret) {
+            cost += model_.ret;
+        } else if (next != line + 1 && next >= 0) {
+            cost += model_.taken;
+        }
+        if (model_.cache != 0 && depth > model_.cache) {
+            cost += model_.spill;
+        }
+        total_ += cost;
+        instructions_++;
+        lines_[line] += cost;
+        executed_[line]++;
+        frames_.back().subroutine->self += cost;
+        // A memoised CALL resumes after itself instead of entering the subroutine
+        if (command == eCommands::Call && next == operand) {
+            enter(next);
+        } else if (command == eCommands::Ret && frames_.size() > 1) {
+            leave();
+        }
+    }
+
+    void report(std::ostream &, const std::function<int(int)> &line_of,
+                const std::function<std::string(int)> &name_of) const;
+
+    [[nodiscard]] uint64_t total() const { return total_; }
+
+private:
+    struct Subroutine {
+        uint64_t self = 0;
+        uint64_t total = 0;
+        uint64_t calls = 0;
+        uint32_t active = 0;
+    };
+
+    struct Frame {
+        Subroutine *subroutine;
+        uint64_t start;
+    };
+
+    void enter(int entry);
+
+    void leave();
+
+    CostModel model_;
+    uint64_t total_ = 0;
+    uint64_t instructions_ = 0;
+    std::vector<uint64_t> lines_;
+    std::vector<uint64_t> executed_;
+    std::map<int, Subroutine> subroutines_;
+    std::vector<Frame> frames_;
+};
@@ -1,6 +1,29 @@
 #pragma once
 
+#include <memory>
+#include <thread>
+#include "cost.h"
+#include "fence.h"
+#include "journal.h"
+#include "perf.h"
 #include "prep.h"
+#include "scheduler.h"
+
+struct RunOptions {
+    std::string metrics_file;
+    eMetricsFormat metrics_format = eMetricsFormat::Json;
+    int metrics_interval = 0;
+    bool perf_counters = false;
+    int perf_sample_period = 0;
+    size_t memo_capacity = 0;
+    std::string profile_file;
+    int workers = -1;
+    uint32_t spawn_cutoff = Scheduler::default_cutoff;
+    std::string record_file;
+    std::string replay_file;
+    std::string cost_model;
+    std::string cost_report;
+};
 
 class CPUEmulator {
 public:
@@ -8,32 +31,201 @@ public:
 
     explicit CPUEmulator(std::string file_name) : file_name_(std::move(file_name)) {}
 
-    void build(const std::string &output_file_name) {
-        proc_.build(file_name_, output_file_name);
+    void build(const std::string &output_file_name, const BuildOptions &options = {}) {
+        proc_.build(file_name_, output_file_name, options);
         clear();
     }
 
-    void run() {
-        proc_.load(file_name_);
-        auto program = proc_.get_program();
-        int line = Begin::instance().get_line();
-        auto stack = std::make_shared<CommandStack>();
-        while (-1 < line && line < program.size()) {
-            auto [command, param] = program[line];
+    void link(const std::vector<std::string> &modules, const BuildOptions &options = {}) {
+        proc_.link(modules, file_name_, options);
+        clear();
+    }
+
+    Trap run(const RunOptions &options = {}) {
+        options_ = options;
+        std::unique_ptr<Journal> journal;
+        auto journal_file = options_.replay_file.empty() ? options_.record_file : options_.replay_file;
+        if (not journal_file.empty()) {
+            try {
+                journal = Journal::open(options_.replay_file.empty() ? eJournal::Record : eJournal::Replay,
+                                        journal_file, 1);
+            } catch (std::runtime_error &e) {
+                std::cerr << e.what() << std::endl;
+                exit(1);
+            }
+            // Tasks run inline, so their inputs reach the journal in program order
+            options_.workers = 0;
+        }
+        std::optional<CostModel> model;
+        if (not options_.cost_model.empty()) {
             try {
-                line = command.run(param, line, stack);
+                model = CostModel::load(options_.cost_model);
             } catch (InvalidArgumentException &e) {
-                std::cerr << "Error in line " << line << ": " << e.what() << std::endl;
-                break;
-            } catch (UniqueException &e) {
-                std::cerr << "Error in line " << line << ": " << e.what() << std::endl;
-                break;
+                std::cerr << "Error in line " << e.line() << ": " << e.what() << std::endl;
+                exit(1);
             } catch (std::runtime_error &e) {
-                std::cerr << "Error in line " << line << ": " << e.what() << std::endl;
-                break;
+                std::cerr << "Can not open file \"" + options_.cost_model + "\"" << std::endl;
+                exit(1);
+            }
+        }
+        if (options_.perf_counters) {
+            perf_ = std::make_unique<PerfCounters>();
+        }
+        start();
+        context_->journal = journal.get();
+        if (model) {
+            cycles_ = std::make_unique<CycleCounter>(*model, proc_.get_decoded().size());
+        }
+        std::unique_ptr<Memo> memo;
+        if (options_.memo_capacity > 0) {
+            memo = std::make_unique<Memo>(proc_.get_pure(), options_.memo_capacity);
+            context_->memo = memo.get();
+        }
+        if (perf_) {
+            perf_->begin_phase();
+        }
+        bool instrumented = not options_.metrics_file.empty();
+        Trap trap;
+        bool profiled = not options_.profile_file.empty();
+        if (profiled) {
+            profile_.assign(proc_.get_decoded().size(), {});
+        }
+        if (cycles_ && profiled) {
+            trap = instrumented ? loop<true, false, true, true>() : loop<false, false, true, true>();
+        } else if (cycles_) {
+            trap = instrumented ? loop<true, false, false, true>() : loop<false, false, false, true>();
+        } else if (profiled) {
+            trap = instrumented ? loop<true, false, true>() : loop<false, false, true>();
+        } else if (perf_ && perf_->available() && options_.perf_sample_period > 0) {
+            trap = instrumented ? loop<true, true>() : loop<false, true>();
+        } else {
+            trap = instrumented ? loop<true>() : resume();
+        }
+        if (perf_) {
+            perf_->end_phase("execute");
+        }
+        if (trap.fault()) {
+            report(trap);
+        }
+        if (perf_) {
+            perf_->report(std::cerr);
+            perf_.reset();
+        }
+        if (memo) {
+            memo->report(std::cerr);
+        }
+        scheduler_.reset();
+        if (journal) {
+            journal->finish(0);
+            try {
+                journal->close(journal_file);
+            } catch (std::runtime_error &e) {
+                std::cerr << e.what() << std::endl;
             }
         }
+        if (not options_.profile_file.empty()) {
+            write_profile();
+        }
+        if (cycles_) {
+            write_cycles();
+        }
+        if (not options_.metrics_file.empty()) {
+            MetricsRegistry::flush();
+            MetricsRegistry::export_to(options_.metrics_file, options_.metrics_format);
+        }
+        registers_.assign(context_->registers, context_->registers + RegisterType::available.size());
+        context_.reset();
         clear();
+        return trap;
+    }
+
+    void start(const RunOptions &options) {
+        options_ = options;
+        start();
+    }
+
+    void start() {
+        if (perf_) {
+            perf_->begin_phase();
+        }
+        proc_.load(file_name_, options_.metrics_file.empty() ? nullptr : &MetricsRegistry::local());
+        if (perf_) {
+            perf_->end_phase("load");
+        }
+        context_ = Context::create(proc_.get_hints());
+        context_->pc = Begin::instance().get_line();
+        if (auto &state = proc_.get_state()) {
+            context_->pc = state->entry;
+            std::copy(state->registers.begin(), state->registers.end(), context_->registers);
+            for (auto value: state->data) {
+                context_->data.push(value);
+            }
+            for (auto value: state->call) {
+                context_->call.push(value);
+            }
+            for (auto value: state->output) {
+                context_->write(value);
+            }
+        }
+        scheduler_.reset();
+        auto &program = proc_.get_decoded();
+        for (int pc = 0; pc < program.size(); pc++) {
+            if (program[pc].command == eCommands::Spawn) {
+                int workers = options_.workers;
+                if (workers < 0) {
+                    workers = static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u)) - 1;
+                }
+                scheduler_ = std::make_unique<Scheduler>(program, workers, options_.spawn_cutoff);
+                context_->scheduler = scheduler_.get();
+                break;
+            }
+        }
+    }
+
+    Trap resume() {
+        return loop<false>();
+    }
+
+    Trap step() {
+        auto &program = proc_.get_decoded();
+        int pc = context_->pc;
+        if (pc < 0 || pc >= program.size()) {
+            return make_trap(0, 0);
+        }
+        auto [command, operand] = program[pc];
+        int next = fenced(*context_, [&] {
+            return command_by_id[static_cast<size_t>(command)]->execute(operand, pc, context_.get());
+        });
+        context_->flush();
+        if (next < 0) {
+            return make_trap(next, operand);
+        }
+        context_->pc = next;
+        return make_trap(0, 0);
+    }
+
+    [[nodiscard]] bool running() {
+        return context_ && -1 < context_->pc && context_->pc < proc_.get_decoded().size();
+    }
+
+    [[nodiscard]] int line() const { return context_->pc; }
+
+    [[nodiscard]] const std::vector<int> &registers() const { return registers_; }
+
+    Context &context() { return *context_; }
+
+    Program &program() { return proc_.get_decoded(); }
+
+    [[nodiscard]] DebugLine debug_line(int pc) const { return proc_.debug_line(pc); }
+
+    [[nodiscard]] std::string label_name(int index) const { return proc_.label_name(index); }
+
+    static void report(const Trap &trap) {
+        if (trap.line == -1) {
+            std::cerr << "Error at instruction " << trap.pc << ": " << trap.message() << std::endl;
+        } else {
+            std::cerr << "Error in line " << trap.line << ": " << trap.message() << std::endl;
+        }
     }
 
     static void clear() {
@@ -42,6 +234,151 @@ public:
 
 
 private:
+    template<bool Instrumented, bool Sampled = false, bool Profiled = false, bool Costed = false>
+    Trap loop() {
+        auto &program = proc_.get_decoded();
+        [[maybe_unused]] auto &metrics = MetricsRegistry::local();
+        [[maybe_unused]] auto started = Metrics::clock::now();
+        [[maybe_unused]] auto exported = started;
+        [[maybe_unused]] uint32_t countdown = 1 << 16;
+        [[maybe_unused]] int sample = options_.perf_sample_period;
+        auto *context = context_.get();
+        int32_t last = 0;
+        int status = fenced(*context, [&] {
+            int line = context->pc;
+            while (-1 < line && line < program.size()) {
+                auto [command, operand] = program[line];
+                [[maybe_unused]] bool timed = false;
+                [[maybe_unused]] bool sampled = false;
+                [[maybe_unused]] Metrics::clock::time_point io;
+                [[maybe_unused]] PerfValues before;
+                if constexpr (Instrumented) {
+                    if ((timed = command == eCommands::In || command == eCommands::Out)) {
+                        io = Metrics::clock::now();
+                    }
+                }
+                if constexpr (Sampled) {
+                    if ((sampled = --sample == 0)) {
+                        sample = options_.perf_sample_period;
+                        before = perf_->read();
+                    }
+                }
+                if constexpr (guarded_stacks) {
+                    context->pc = line;
+                }
+                int next = command_by_id[static_cast<size_t>(command)]->execute(operand, line, context);
+                if constexpr (Sampled) {
+                    if (sampled) {
+                        perf_->attribute(command, before, perf_->read());
+                    }
+                }
+                if constexpr (Instrumented) {
+                    if (timed) {
+                        metrics.phases[static_cast<size_t>(ePhase::IO)] += Metrics::clock::now() - io;
+                    }
+                    metrics.peak_data = std::max(metrics.peak_data, context->data.size());
+                    metrics.peak_call = std::max(metrics.peak_call, context->call.size());
+                    if (next >= trap(eTrap::Halt)) {
+                        metrics.retired[static_cast<size_t>(command)]++;
+                    }
+                }
+                if constexpr (Costed) {
+                    if (next >= trap(eTrap::Halt)) {
+                        cycles_->account(command, operand, line, next, context->data.size());
+                    }
+                }
+                if constexpr (Profiled) {
+                    auto &counts = profile_[line];
+                    counts.count++;
+                    counts.taken += next >= 0 && next != line + 1;
+                }
+                if (next < 0) {
+                    context->pc = line;
+                    last = operand;
+                    return next;
+                }
+                if constexpr (Instrumented) {
+                    if (--countdown == 0) {
+                        countdown = 1 << 16;
+                        auto now = Metrics::clock::now();
+                        auto interval = std::chrono::seconds(options_.metrics_interval);
+                        if (options_.metrics_interval > 0 && now - exported >= interval) {
+                            metrics.phases[static_cast<size_t>(ePhase::Execute)] += now - started;
+                            started = exported = now;
+                            MetricsRegistry::export_to(options_.metrics_file, options_.metrics_format);
+                        }
+                    }
+                }
+                line = next;
+            }
+            context->pc = line;
+            return 0;
+        });
+        context->flush();
+        if constexpr (Instrumented) {
+            metrics.phases[static_cast<size_t>(ePhase::Execute)] += Metrics::clock::now() - started;
+        }
+        return make_trap(status, last);
+    }
+
+    void write_profile() {
+        std::ofstream file(options_.profile_file);
+        if (not file.is_open()) {
+            std::cerr << "Can not create file \"" + options_.profile_file + "\"" << std::endl;
+            return;
+        }
+        Profile profile;
+        bool lines = false;
+        for (int pc = 0; pc < profile_.size(); pc++) {
+            int line = proc_.debug_line(pc).line;
+            if (line == -1) {
+                continue;
+            }
+            lines = true;
+            if (profile_[pc].count > 0) {
+                profile[line].count += profile_[pc].count;
+                profile[line].taken += profile_[pc].taken;
+            }
+        }
+        if (not lines && not profile_.empty()) {
+            std::cerr << "Program has no debug lines, the profile is empty" << std::endl;
+        }
+        Layout::write(file, profile);
+        profile_.clear();
+    }
+
+    void write_cycles() {
+        std::ofstream file;
+        if (not options_.cost_report.empty()) {
+            file.open(options_.cost_report);
+            if (not file.is_open()) {
+                std::cerr << "Can not create file \"" + options_.cost_report + "\"" << std::endl;
+                cycles_.reset();
+                return;
+            }
+        }
+        cycles_->report(options_.cost_report.empty() ? std::cerr : file, [this](int pc) {
+            return proc_.debug_line(pc).line;
+        }, [this](int pc) {
+            auto name = proc_.label_at(pc);
+            return name.empty() ? "instruction " + std::to_string(pc) : name;
+        });
+        cycles_.reset();
+    }
+
+    Trap make_trap(int status, int32_t operand) {
+        int pc = context_->pc;
+        return {static_cast<eTrap>(-status), pc, proc_.debug_line(pc).line, context_->data.size(), context_->call.size(),
+                operand};
+    }
+
     std::string file_name_;
     Preprocessor proc_;
+    RunOptions options_;
+    std::unique_ptr<PerfCounters> perf_;
+    std::vector<EdgeCounts> profile_;
+    std::unique_ptr<CycleCounter> cycles_;
+    std::vector<int> registers_;
+    Context::Pointer context_;
+    std::unique_ptr<Scheduler> scheduler_;
 };
\ No newline at end of file
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <string>
+#include <unordered_map>
 #include <vector>
+#include <algorithm>
 #include "exc.h"
 
 
@@ -9,35 +11,39 @@ class RegisterType {
 private:
     std::string name_;
 
-    int value_ = 0;
-
     explicit RegisterType(std::string name) : name_(std::move(name)) {}
 
-    static inline std::vector<RegisterType> regs_ = {};
+    static std::vector<RegisterType> make_all() {
+        std::vector<RegisterType> regs;
+        for (auto &name: available) {
+            regs.push_back(RegisterType(name));
+        }
+        return regs;
+    }
+
+public:
+    const static inline std::vector<std::string> available = {"ax", "bx", "cx", "dx", "ex"};
+
+private:
+    static inline std::vector<RegisterType> regs_ = make_all();
 
 public:
     static RegisterType &get(const std::string &name) {
-        if (std::find(available.begin(), available.end(), name) == available.end()) {
+        int i = index(name);
+        if (i == -1) {
             throw InvalidArgumentException("Incorrect register name \"" + name + "\"");
         }
-        for (auto &i: regs_) {
-            if (i.name_ == name) {
-                return i;
-            }
-        }
-        regs_.push_back(RegisterType(name));
-        return regs_.back();
+        return regs_[i];
     }
 
-    int &value() { return value_; }
-
-    const std::string &name() { return name_; }
+    static RegisterType &at(int index) { return regs_[index]; }
 
-    static void clear_all() {
-        regs_.clear();
+    static int index(const std::string &name) {
+        auto it = std::find(available.begin(), available.end(), name);
+        return it == available.end() ? -1 : static_cast<int>(it - available.begin());
     }
 
-    const static inline std::vector<std::string> available = {"ax", "bx", "cx", "dx", "ex"};
+    const std::string &name() { return name_; }
 };
 
 class LabelType {
@@ -46,6 +52,7 @@ private:
     int line_ = -1;
 
     static inline std::vector<LabelType> labels_;
+    static inline std::unordered_map<std::string, int> index_;
 
     explicit LabelType(std::string name) : name_(std::move(name)) {}
 
@@ -63,26 +70,27 @@ public:
                 throw InvalidArgumentException("Incorrect label name \"" + name + "\"");
             }
         }
-        for (auto &i: labels_) {
-            if (i.name_ == name) {
-                return i;
-            }
+        auto [it, inserted] = index_.try_emplace(name, static_cast<int>(labels_.size()));
+        if (inserted) {
+            labels_.push_back(LabelType(name));
         }
-        labels_.push_back(LabelType(name));
-        return labels_.back();
+        return labels_[it->second];
     }
 
+    static LabelType &at(int index) { return labels_[index]; }
+
+    static int count() { return static_cast<int>(labels_.size()); }
+
     static void clear_all() {
         labels_.clear();
+        index_.clear();
     }
 
     int &line() { return line_; }
 
-    const std::string &name() { return name_; }
-};
+    [[nodiscard]] int target() const {
+        return line_ != -1 ? line_ : -static_cast<int>(this - labels_.data()) - 1;
+    }
 
-class CommandStack {
-public:
-    stack::Stack<int> data;
-    stack::Stack<int> call;
+    const std::string &name() { return name_; }
 };
\ No newline at end of file
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <iostream>
+#include <map>
+#include <sstream>
+#include "cpu.h"
+
+class Debugger {
+public:
+    Debugger(CPUEmulator &emulator, std::istream &input, std::ostream &output)
+            : emulator_(emulator), input_(input), output_(output) {}
+
+    void run() {
+        emulator_.start();
+        where();
+        std::string line;
+        while (output_ << "(debug) " << std::flush, std::getline(input_, line)) {
+            std::stringstream stream(line);
+            std::string command;
+            stream >> command;
+            if (command.empty()) {
+                continue;
+            }
+            if (command == "quit" || command == "q") {
+                break;
+            } else if (command == "break" || command == "b") {
+                int pc = -1;
+                stream >> pc;
+                set_breakpoint(pc);
+            } else if (command == "delete" || command == "d") {
+                int pc = -1;
+                stream >> pc;
+                remove_breakpoint(pc);
+            } else if (command == "step" || command == "s") {
+                int count = 1;
+                stream >> count;
+                for (int i = 0; i < count && proceed(true); i++) {}
+                where();
+            } else if (command == "continue" || command == "c") {
+                proceed(false);
+                where();
+            } else if (command == "stack") {
+                print(emulator_.context().data);
+            } else if (command == "calls") {
+                print(emulator_.context().call);
+            } else if (command == "regs") {
+                for (int i = 0; i < RegisterType::available.size(); i++) {
+                    output_ << RegisterType::available[i] << " = " << emulator_.context().registers[i] << '\n';
+                }
+            } else if (command == "where") {
+                where();
+            } else if (command == "breakpoints") {
+                for (auto &[pc, instruction]: breakpoints_) {
+                    output_ << pc << ": " << describe(instruction) << '\n';
+                }
+            } else {
+                output_ << "Unknown command \"" << command << "\"\n";
+            }
+        }
+        for (auto &[pc, instruction]: breakpoints_) {
+            emulator_.program().patch(pc, instruction);
+        }
+        breakpoints_.clear();
+        CPUEmulator::clear();
+    }
+
+private:
+    void set_breakpoint(int pc) {
+        auto &program = emulator_.program();
+        if (pc < 0 || pc >= program.size()) {
+            output_ << "No instruction at " << pc << '\n';
+            return;
+        }
+        if (not breakpoints_.contains(pc)) {
+            breakpoints_[pc] = program[pc];
+            program.patch(pc, {eCommands::Break, 0});
+        }
+        output_ << "Breakpoint at " << pc << ": " << describe(breakpoints_[pc]) << '\n';
+    }
+
+    void remove_breakpoint(int pc) {
+        if (not breakpoints_.contains(pc)) {
+            output_ << "No breakpoint at " << pc << '\n';
+            return;
+        }
+        emulator_.program().patch(pc, breakpoints_[pc]);
+        breakpoints_.erase(pc);
+    }
+
+    bool proceed(bool single) {
+        if (finished_ || not emulator_.running()) {
+            output_ << "Program is not running\n";
+            return false;
+        }
+        Trap trap;
+        int pc = emulator_.line();
+        if (breakpoints_.contains(pc)) {
+            emulator_.program().patch(pc, breakpoints_[pc]);
+            trap = emulator_.step();
+            emulator_.program().patch(pc, {eCommands::Break, 0});
+            if (trap.kind == eTrap::Ok && not single) {
+                trap = emulator_.resume();
+            }
+        } else {
+            trap = single ? emulator_.step() : emulator_.resume();
+        }
+        if (trap.kind == eTrap::Breakpoint) {
+            output_ << "Breakpoint hit\n";
+            return false;
+        }
+        if (trap.kind == eTrap::Halt || (trap.kind == eTrap::Ok && not emulator_.running())) {
+            output_ << "Program finished\n";
+            finished_ = true;
+            return false;
+        }
+        if (trap.fault()) {
+            CPUEmulator::report(trap);
+            finished_ = true;
+            return false;
+        }
+        return true;
+    }
+
+    void where() {
+        if (finished_ || not emulator_.running()) {
+            return;
+        }
+        int pc = emulator_.line();
+        auto instruction = breakpoints_.contains(pc) ? breakpoints_[pc] : emulator_.program()[pc];
+        output_ << "At " << pc;
+        auto debug = emulator_.debug_line(pc);
+        if (debug.line != -1) {
+            output_ << " (line " << debug.line;
+            if (debug.label != -1) {
+                output_ << " in " << emulator_.label_name(debug.label);
+            }
+            output_ << ')';
+        }
+        output_ << ": " << describe(instruction) << '\n';
+    }
+
+    void print(ArenaStack<int> &values) {
+        output_ << '[';
+        for (uint32_t i = 0; i < values.size(); i++) {
+            output_ << (i == 0 ? "" : ", ") << values.at(i);
+        }
+        output_ << "]\n";
+    }
+
+    static std::string describe(const Instruction &instruction) {
+        auto text = command_name.at(instruction.command);
+        switch (instruction.command) {
+            case eCommands::Push:
+            case eCommands::Send:
+            case eCommands::Recv:
+            case eCommands::Memory:
+                return text + " " + std::to_string(instruction.operand);
+            case eCommands::PushR:
+            case eCommands::PopR:
+            case eCommands::LoadR:
+            case eCommands::StoreR:
+                return text + " " + RegisterType::available[instruction.operand];
+            default:
+                if (ControlFlowGraph::is_jump(instruction.command) || instruction.command == eCommands::Label) {
+                    return text + " " + (instruction.operand < 0 ? "?" : std::to_string(instruction.operand));
+                }
+                return text;
+        }
+    }
+
+    CPUEmulator &emulator_;
+    std::istream &input_;
+    std::ostream &output_;
+    std::map<int, Instruction> breakpoints_;
+    bool finished_ = false;
+};
@@ -0,0 +1,85 @@
+#include "evaluator.h"
+#include "fence.h"
+#include "optimizer.h"
+
+std::vector<int> PartialEvaluator::drain(ArenaStack<int> &stack) {
+    std::vector<int> values(stack.size());
+    for (auto it = values.rbegin(); it != values.rend(); it++) {
+        *it = stack.top();
+        stack.pop();
+    }
+    return values;
+}
+
+std::optional<ProgramState> PartialEvaluator::run(std::vector<Statement> &program) const {
+    std::vector<BaseCommand *> commands;
+    commands.reserve(program.size());
+    int line = 0;
+    for (auto &statement: program) {
+        commands.push_back(command_by_id[static_cast<size_t>(statement.command)]);
+        commands.back()->configure(statement.param, line++);
+    }
+    int begin = Begin::instance().get_line();
+    if (begin == -1) {
+        return std::nullopt;
+    }
+    std::vector<Instruction> code;
+    code.reserve(program.size());
+    for (int i = 0; i < program.size(); i++) {
+        code.push_back({program[i].command, commands[i]->encode(program[i].param)});
+    }
+
+    ProgramState state;
+    auto context = Context::create();
+    int pc = begin;
+    int steps = 0;
+    while (0 <= pc && pc < code.size() && steps < budget_) {
+        auto [command, operand] = code[pc];
+        if (command == eCommands::In || command == eCommands::End || command == eCommands::Send ||
+            command == eCommands::Recv || command == eCommands::Spawn || command == eCommands::Join ||
+            ControlFlowGraph::is_memory(command) || (command == eCommands::Out && context->data.empty())) {
+            break;
+        }
+        if (command == eCommands::Out) {
+            state.output.push_back(context->data.top());
+            context->data.pop();
+            pc++;
+        } else {
+            int next = fenced(*context, [&] { return commands[pc]->execute(operand, pc, context.get()); });
+            if (next < 0) {
+                break;
+            }
+            pc = next;
+        }
+        steps++;
+    }
+    if (steps <= 1 && state.output.empty()) {
+        return std::nullopt;
+    }
+
+    state.registers.assign(context->registers, context->registers + RegisterType::available.size());
+    state.data = drain(context->data);
+    state.call = drain(context->call);
+
+    if (pc < 0 || pc >= program.size() || program[pc].command == eCommands::End) {
+        // Running off the end finishes the program, only an END halts it
+        bool halted = 0 <= pc && pc < program.size();
+        int end = halted ? program[pc].line : program.back().line;
+        program = {{eCommands::Begin, "", program[begin].line},
+                   {halted ? eCommands::End : eCommands::Blank, "", end}};
+        state.entry = 0;
+    } else if (state.call.empty()) {
+        program[begin] = {eCommands::Blank, "", program[begin].line};
+        program.insert(program.begin() + pc, {eCommands::Begin, "", program[pc].line});
+        Optimizer::remove_unreachable(program);
+        while (Optimizer::remove_dead_stores(program)) {}
+        for (int i = 0; i < program.size(); i++) {
+            if (program[i].command == eCommands::Begin) {
+                state.entry = i;
+            }
+        }
+    } else {
+        state.entry = pc;
+    }
+    return state;
+}
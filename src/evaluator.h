@@ -0,0 +1,18 @@
+#pragma once
+
+#include <optional>
+#include <vector>
+#include "program.h"
+#include "parser.h"
+
+class PartialEvaluator {
+public:
+    explicit PartialEvaluator(int budget) : budget_(budget) {}
+
+    std::optional<ProgramState> run(std::vector<Statement> &) const;
+
+private:
+    static std::vector<int> drain(ArenaStack<int> &);
+
+    int budget_;
+};
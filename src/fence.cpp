@@ -0,0 +1,52 @@
+#include "fence.h"
+
+#ifdef EMU_GUARDED_STACKS
+
+#include <mutex>
+#include <csignal>
+
+namespace {
+    thread_local StackFence *active = nullptr;
+
+    void on_fault(int signal, siginfo_t *info, void *) {
+        if (active != nullptr) {
+            if (int status = active->classify(info->si_addr)) {
+                siglongjmp(active->env, status);
+            }
+        }
+        struct sigaction action{};
+        action.sa_handler = SIG_DFL;
+        sigaction(signal, &action, nullptr);
+    }
+}
+
+StackFence::StackFence(Context &context) : context_(context), previous_(active) {
+    static std::once_flag installed;
+    std::call_once(installed, [] {
+        struct sigaction action{};
+        action.sa_sigaction = on_fault;
+        action.sa_flags = SA_SIGINFO | SA_NODEFER;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGSEGV, &action, nullptr);
+    });
+    active = this;
+}
+
+StackFence::~StackFence() {
+    active = previous_;
+}
+
+int StackFence::classify(const void *address) const {
+    if (context_.data.below(address)) {
+        return trap(eTrap::StackUnderflow);
+    }
+    if (context_.call.below(address)) {
+        return trap(eTrap::CallStackUnderflow);
+    }
+    if (context_.data.above(address) || context_.call.above(address)) {
+        return trap(eTrap::StackOverflow);
+    }
+    return 0;
+}
+
+#endif
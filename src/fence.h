@@ -0,0 +1,39 @@
+#pragma once
+
+#include <csetjmp>
+#include "context.h"
+#include "trap.h"
+
+#ifdef EMU_GUARDED_STACKS
+
+class StackFence {
+public:
+    explicit StackFence(Context &context);
+
+    ~StackFence();
+
+    StackFence(const StackFence &) = delete;
+
+    StackFence &operator=(const StackFence &) = delete;
+
+    [[nodiscard]] int classify(const void *address) const;
+
+    sigjmp_buf env{};
+
+private:
+    Context &context_;
+    StackFence *previous_;
+};
+
+#endif
+
+template<class F>
+int fenced(Context &context, F &&body) {
+#ifdef EMU_GUARDED_STACKS
+    StackFence fence(context);
+    if (int status = sigsetjmp(fence.env, 0)) {
+        return status;
+    }
+#endif
+    return body();
+}
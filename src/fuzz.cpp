@@ -0,0 +1,669 @@
+#include <sys/wait.h>
+#include <unistd.h>
+#include <climits>
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include "cpu.h"
+
+namespace {
+    constexpr unsigned timeout_seconds = 10;
+
+    struct Outcome {
+        std::string status;
+        std::string output;
+        std::vector<int> registers;
+    };
+
+    struct Engine {
+        std::string name;
+        std::function<Outcome(const std::string &, const std::string &)> run;
+        bool registers = true;
+        bool halts = true;
+    };
+
+    class Capture {
+    public:
+        explicit Capture(const std::string &input) : input_(input), in_(std::cin.rdbuf(input_.rdbuf())),
+                                                     out_(std::cout.rdbuf(output_.rdbuf())),
+                                                     err_(std::cerr.rdbuf(errors_.rdbuf())) {}
+
+        ~Capture() {
+            std::cin.rdbuf(in_);
+            std::cout.rdbuf(out_);
+            std::cerr.rdbuf(err_);
+        }
+
+        Capture(const Capture &) = delete;
+
+        Capture &operator=(const Capture &) = delete;
+
+        void reset(const std::string &input) {
+            input_.clear();
+            input_.str(input);
+            std::cin.clear();
+            output_.str("");
+        }
+
+        [[nodiscard]] std::string output() const { return output_.str(); }
+
+    private:
+        std::stringstream input_;
+        std::stringstream output_;
+        std::stringstream errors_;
+        std::streambuf *in_;
+        std::streambuf *out_;
+        std::streambuf *err_;
+    };
+
+    std::string status_of(eTrap kind) {
+        return Trap{kind}.message();
+    }
+
+    std::string status_of(const std::string &message) {
+        if (message.starts_with("Can not find label")) {
+            return status_of(eTrap::UnresolvedLabel);
+        }
+        if (message.starts_with("Channel ")) {
+            return status_of(eTrap::Disconnected);
+        }
+        if (message.starts_with("Blocked on channel")) {
+            return status_of(eTrap::Blocked);
+        }
+        return message;
+    }
+
+    std::string read_file(const std::string &file_name) {
+        std::ifstream file(file_name);
+        std::stringstream text;
+        text << file.rdbuf();
+        return text.str();
+    }
+
+    Outcome reference(const std::string &source, const std::string &input) {
+        Capture capture(input);
+        Parser parser;
+        std::vector<std::tuple<BaseCommand &, std::string>> program;
+        Program decoded;
+        try {
+            parser.parse(source);
+            program = parser.get_program();
+            for (int line = 0; line < program.size(); line++) {
+                std::get<0>(program[line]).configure(std::get<1>(program[line]), line);
+            }
+        } catch (InvalidArgumentException &) {
+            return {"build"};
+        } catch (UniqueException &) {
+            return {"build"};
+        }
+        for (auto [command, param]: program) {
+            decoded.push_back({command.name(), command.encode(param)});
+        }
+        auto context = Context::create({.memory = Memory::instance().get_size()});
+        Scheduler scheduler(decoded, 0);
+        context->scheduler = &scheduler;
+        auto status = status_of(eTrap::Ok);
+        int pc = Begin::instance().get_line();
+        try {
+            while (-1 < pc && pc < program.size()) {
+                auto [command, param] = program[pc];
+                int next = command.run(param, pc, context.get());
+                if (next < 0) {
+                    status = status_of(static_cast<eTrap>(-next));
+                    break;
+                }
+                pc = next;
+            }
+        } catch (InvalidArgumentException &e) {
+            status = status_of(e.what());
+        } catch (std::runtime_error &e) {
+            status = status_of(e.what());
+        }
+        context->flush();
+        return {status, capture.output(),
+                std::vector<int>(context->registers, context->registers + RegisterType::available.size())};
+    }
+
+    Engine emulator(const std::string &name, BuildOptions build, RunOptions options = {}) {
+        return {name, [=](const std::string &source, const std::string &input) {
+            Capture capture(input);
+            auto binary = source + "." + name;
+            auto profiled = build;
+            if (not build.profile_file.empty()) {
+                profiled.profile_file.clear();
+                CPUEmulator(source).build(binary, profiled);
+                RunOptions profiling;
+                profiling.profile_file = build.profile_file;
+                CPUEmulator(binary + ".emu").run(profiling);
+                capture.reset(input);
+            }
+            CPUEmulator(source).build(binary, build);
+            CPUEmulator app(binary + ".emu");
+            auto trap = app.run(options);
+            return Outcome{status_of(trap.kind), capture.output(), app.registers()};
+        }, build.opt_level == 0};
+    }
+
+    Engine native() {
+        return {"native", [](const std::string &source, const std::string &input) {
+            // Tasks have no C translation, such programs are outside this engine
+            std::ifstream program(source);
+            for (std::string word; program >> word;) {
+                if (word == "spawn" || word == "join") {
+                    return Outcome{"skipped"};
+                }
+            }
+            Capture capture(input);
+            auto binary = source + ".native";
+            CPUEmulator(source).build(binary, {.emit_c = true, .native = true});
+            std::ofstream(binary + ".in") << input;
+            auto command = "\"" + binary + "\" < \"" + binary + ".in\" > \"" + binary + ".out\" 2> \"" + binary +
+                           ".err\"";
+            if (std::system(command.c_str()) != 0) {
+                return Outcome{"crash"};
+            }
+            auto errors = read_file(binary + ".err");
+            auto status = status_of(eTrap::Ok);
+            if (auto colon = errors.find(": "); errors.starts_with("Error in line ") && colon != std::string::npos) {
+                status = status_of(errors.substr(colon + 2, errors.find('\n') - colon - 2));
+            }
+            return Outcome{status, read_file(binary + ".out")};
+        }, false, false};
+    }
+
+    std::string encode(const Outcome &outcome) {
+        std::string text = outcome.status + "\n";
+        for (int value: outcome.registers) {
+            text += std::to_string(value) + " ";
+        }
+        return text + "\n" + outcome.output;
+    }
+
+    Outcome decode(const std::string &text) {
+        std::stringstream stream(text);
+        Outcome outcome;
+        std::string registers;
+        std::getline(stream, outcome.status);
+        std::getline(stream, registers);
+        std::stringstream values(registers);
+        for (int value; values >> value;) {
+            outcome.registers.push_back(value);
+        }
+        outcome.output = text.substr(std::min<size_t>(text.size(), stream.tellg()));
+        return outcome;
+    }
+
+    // Runs an engine in a child process, so hangs, crashes and exit() calls of a build are contained
+    Outcome isolate(const Engine &engine, const std::string &source, const std::string &input) {
+        int pipe_fds[2];
+        if (pipe(pipe_fds) != 0) {
+            throw std::runtime_error("Can not create pipe");
+        }
+        std::cout.flush();
+        std::cerr.flush();
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(pipe_fds[0]);
+            alarm(timeout_seconds);
+            auto text = encode(engine.run(source, input));
+            for (size_t written = 0; written < text.size();) {
+                auto count = write(pipe_fds[1], text.data() + written, text.size() - written);
+                if (count <= 0) {
+                    break;
+                }
+                written += count;
+            }
+            _exit(0);
+        }
+        close(pipe_fds[1]);
+        std::string text;
+        char buffer[4096];
+        for (ssize_t count; (count = read(pipe_fds[0], buffer, sizeof(buffer))) > 0;) {
+            text.append(buffer, count);
+        }
+        close(pipe_fds[0]);
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (WIFSIGNALED(status)) {
+            return {WTERMSIG(status) == SIGALRM ? "timeout" : "crash " + std::to_string(WTERMSIG(status))};
+        }
+        if (WEXITSTATUS(status) != 0) {
+            return {"build"};
+        }
+        return decode(text);
+    }
+
+    class Generator {
+    public:
+        explicit Generator(uint32_t seed) : random_(seed) {}
+
+        std::vector<std::string> program() {
+            int count = pick(0, 4);
+            subroutines_.assign(count, {});
+            std::vector<std::vector<std::string>> bodies(count);
+            for (int i = count - 1; i >= 0; i--) {
+                subroutines_[i].quiet = chance(50);
+                subroutines_[i].net = pick(0, 1);
+                lines_.clear();
+                emit("s" + std::to_string(i) + ":");
+                block(i, subroutines_[i].quiet, false, 0);
+                if (subroutines_[i].net == 1) {
+                    emit("pushr " + reg(true));
+                }
+                emit("ret");
+                bodies[i] = lines_;
+            }
+            lines_.clear();
+            emit("memory " + std::to_string(memory_size));
+            for (auto &body: bodies) {
+                lines_.insert(lines_.end(), body.begin(), body.end());
+            }
+            emit("beg");
+            for (int n = pick(1, 3); n > 0; n--) {
+                block(-1, false, true, 0);
+            }
+            // Optimizers may drop register stores nobody reads, so dump them where every engine must agree
+            for (auto &name: RegisterType::available) {
+                emit("pushr " + name);
+                emit("out");
+            }
+            emit("push 0");
+            emit("push " + std::to_string(memory_size));
+            emit("memsum");
+            emit("out");
+            emit("end");
+            return lines_;
+        }
+
+        std::string input() {
+            std::string text;
+            for (int n = 0; n < 8; n++) {
+                text += std::to_string(pick(-20, 20)) + "\n";
+            }
+            return text;
+        }
+
+    private:
+        static constexpr int memory_size = 16;
+
+        struct Subroutine {
+            bool quiet = false;
+            int net = 0;
+        };
+
+        int pick(int low, int high) {
+            return std::uniform_int_distribution<int>(low, high)(random_);
+        }
+
+        bool chance(int percent) {
+            return pick(0, 99) < percent;
+        }
+
+        void emit(const std::string &line) {
+            lines_.push_back(line);
+        }
+
+        std::string label() {
+            return "L" + std::to_string(labels_++);
+        }
+
+        std::string constant() {
+            static const std::vector<int> edges = {0, 1, -1, 2, 7, 100, INT_MAX, INT_MIN};
+            return std::to_string(chance(30) ? edges[pick(0, static_cast<int>(edges.size()) - 1)] : pick(-1000, 1000));
+        }
+
+        // ex is reserved for loop counters, so only reads may name it
+        std::string reg(bool read) {
+            return RegisterType::available[pick(0, static_cast<int>(RegisterType::available.size()) - (read ? 1 : 2))];
+        }
+
+        int callee(int self, bool quiet) {
+            std::vector<int> candidates;
+            for (int j = self + 1; j < subroutines_.size(); j++) {
+                if (not quiet || subroutines_[j].quiet) {
+                    candidates.push_back(j);
+                }
+            }
+            return candidates.empty() ? -1 : candidates[pick(0, static_cast<int>(candidates.size()) - 1)];
+        }
+
+        // Emits a block that leaves the stack as it found it, unless a deliberately wild instruction traps
+        void block(int self, bool quiet, bool loops, int nesting) {
+            static const std::vector<std::string> arithmetic = {"add", "sub", "mul"};
+            static const std::vector<std::string> conditions = {"jeq", "jne", "ja", "jae", "jb", "jbe"};
+            static const std::vector<std::string> wild = {"pop", "add", "div", "ret", "send 1", "recv 0", "join",
+                                                          "load", "memsum"};
+            int depth = 0;
+            for (int n = nesting == 0 ? pick(4, 16) : pick(1, 6); n > 0; n--) {
+                switch (pick(0, 14)) {
+                    case 0:
+                        emit("push " + constant());
+                        depth++;
+                        break;
+                    case 1:
+                        emit("pushr " + reg(true));
+                        depth++;
+                        break;
+                    case 2:
+                        if (depth >= 1) {
+                            emit("popr " + reg(false));
+                            depth--;
+                        }
+                        break;
+                    case 3:
+                        if (depth >= 1) {
+                            emit("pop");
+                            depth--;
+                        }
+                        break;
+                    case 4:
+                        if (depth >= 2) {
+                            emit(arithmetic[pick(0, 2)]);
+                            depth--;
+                        }
+                        break;
+                    case 5:
+                        if (depth >= 1) {
+                            emit("push " + std::to_string(chance(50) ? pick(1, 9) : pick(-9, -1)));
+                            emit("div");
+                        }
+                        break;
+                    case 6:
+                        if (not quiet) {
+                            emit("in");
+                            depth++;
+                        }
+                        break;
+                    case 7:
+                        if (not quiet && depth >= 1) {
+                            emit("out");
+                            depth--;
+                        }
+                        break;
+                    case 8:
+                        if (int j = callee(self, quiet); j != -1) {
+                            emit("call s" + std::to_string(j));
+                            depth += subroutines_[j].net;
+                        }
+                        break;
+                    case 9:
+                        if (int j = callee(self, true); j != -1) {
+                            int count = pick(0, std::min(depth, 2));
+                            emit("push " + std::to_string(count));
+                            emit("spawn s" + std::to_string(j));
+                            emit("join");
+                            depth += count + subroutines_[j].net;
+                        }
+                        break;
+                    case 10:
+                        if (nesting < 2) {
+                            auto skip = label();
+                            emit("push " + constant());
+                            emit("pushr " + reg(true));
+                            emit(conditions[pick(0, 5)] + " " + skip);
+                            block(self, quiet, false, nesting + 1);
+                            emit(skip + ":");
+                            emit("pop");
+                            emit("pop");
+                        }
+                        break;
+                    case 11:
+                        if (nesting < 2) {
+                            auto skip = label();
+                            emit("jmp " + skip);
+                            block(self, quiet, false, nesting + 1);
+                            emit(skip + ":");
+                        }
+                        break;
+                    case 12:
+                        if (loops && nesting == 0) {
+                            auto head = label();
+                            emit("push " + std::to_string(pick(0, 4)));
+                            emit("popr ex");
+                            emit("pushr ex");
+                            emit("push 0");
+                            emit(head + ":");
+                            emit("pop");
+                            emit("pop");
+                            block(self, quiet, false, nesting + 1);
+                            emit("pushr ex");
+                            emit("push 1");
+                            emit("sub");
+                            emit("popr ex");
+                            emit("pushr ex");
+                            emit("push 0");
+                            emit("jb " + head);
+                            emit("pop");
+                            emit("pop");
+                        }
+                        break;
+                    case 13: {
+                        // Addresses stay in bounds, the wild instructions cover the traps
+                        int address = pick(0, memory_size - 1);
+                        int count = pick(0, memory_size - address);
+                        switch (pick(0, 5)) {
+                            case 0:
+                                emit("push " + constant());
+                                emit("push " + std::to_string(address));
+                                emit("store");
+                                break;
+                            case 1:
+                                emit("push " + std::to_string(address));
+                                emit("load");
+                                depth++;
+                                break;
+                            case 2: {
+                                auto name = reg(false);
+                                emit("push " + std::to_string(address));
+                                emit("popr " + name);
+                                if (chance(50)) {
+                                    emit("loadr " + name);
+                                    depth++;
+                                } else {
+                                    emit("push " + constant());
+                                    emit("storer " + name);
+                                }
+                                break;
+                            }
+                            case 3:
+                                emit("push " + std::to_string(address));
+                                emit("push " + constant());
+                                emit("push " + std::to_string(count));
+                                emit("memset");
+                                break;
+                            case 4:
+                                emit("push " + std::to_string(pick(0, memory_size - count)));
+                                emit("push " + std::to_string(address));
+                                emit("push " + std::to_string(count));
+                                emit("memcpy");
+                                break;
+                            default:
+                                emit("push " + std::to_string(address));
+                                emit("push " + std::to_string(count));
+                                emit("memsum");
+                                depth++;
+                                break;
+                        }
+                        break;
+                    }
+                    default:
+                        if (chance(10)) {
+                            emit(wild[pick(0, static_cast<int>(wild.size()) - 1)]);
+                        } else {
+                            emit(chance(50) ? "" : "// filler");
+                        }
+                        break;
+                }
+            }
+            for (; depth > 0; depth--) {
+                emit(quiet || chance(50) ? "pop" : "out");
+            }
+        }
+
+        std::mt19937 random_;
+        std::vector<std::string> lines_;
+        std::vector<Subroutine> subroutines_;
+        int labels_ = 0;
+    };
+
+    class Fuzzer {
+    public:
+        Fuzzer(std::vector<Engine> engines, std::string directory) : engines_(std::move(engines)),
+                                                                     directory_(std::move(directory)) {}
+
+        // Returns the engines whose outcome differs from the reference path
+        std::vector<std::string> check(const std::vector<std::string> &lines, const std::string &input) {
+            auto source = directory_ + "/case.txt";
+            std::ofstream file(source);
+            for (auto &line: lines) {
+                file << line << '\n';
+            }
+            file.close();
+            auto expected = isolate({"reference", reference}, source, input);
+            std::vector<std::string> mismatches;
+            for (auto &engine: engines_) {
+                auto actual = isolate(engine, source, input);
+                if (differs(expected, actual, engine)) {
+                    mismatches.push_back(engine.name + ": " + describe(actual) + " (reference: " +
+                                         describe(expected) + ")");
+                }
+            }
+            return mismatches;
+        }
+
+        std::vector<std::string> minimise(std::vector<std::string> lines, const std::string &input) {
+            for (size_t chunk = std::max<size_t>(lines.size() / 2, 1);; chunk /= 2) {
+                for (bool changed = true; changed;) {
+                    changed = false;
+                    for (size_t start = 0; start + chunk <= lines.size();) {
+                        auto candidate = lines;
+                        candidate.erase(candidate.begin() + static_cast<long>(start),
+                                        candidate.begin() + static_cast<long>(start + chunk));
+                        if (not check(candidate, input).empty()) {
+                            lines = std::move(candidate);
+                            changed = true;
+                        } else {
+                            start += chunk;
+                        }
+                    }
+                }
+                if (chunk == 1) {
+                    return lines;
+                }
+            }
+        }
+
+    private:
+        static bool differs(const Outcome &expected, const Outcome &actual, const Engine &engine) {
+            auto status = [&engine](const std::string &text) {
+                return not engine.halts && text == status_of(eTrap::Halt) ? status_of(eTrap::Ok) : text;
+            };
+            if (actual.status == "skipped") {
+                return false;
+            }
+            if (status(expected.status) != status(actual.status) || expected.output != actual.output) {
+                return true;
+            }
+            return engine.registers && expected.registers != actual.registers;
+        }
+
+        static std::string describe(const Outcome &outcome) {
+            auto output = outcome.output;
+            std::replace(output.begin(), output.end(), '\n', ' ');
+            return "[" + outcome.status + "] " + output.substr(0, 60);
+        }
+
+        std::vector<Engine> engines_;
+        std::string directory_;
+    };
+}
+
+int main(int argc, char **argv) {
+    uint32_t seed = std::random_device()();
+    int iterations = 100;
+    bool compile = false;
+    std::string directory = "fuzz";
+    std::string replay;
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        if (option.starts_with("--seed=")) {
+            seed = std::stoul(option.substr(option.find('=') + 1));
+        } else if (option.starts_with("--iterations=")) {
+            iterations = std::stoi(option.substr(option.find('=') + 1));
+        } else if (option.starts_with("--dir=")) {
+            directory = option.substr(option.find('=') + 1);
+        } else if (option.starts_with("--check=")) {
+            replay = option.substr(option.find('=') + 1);
+        } else if (option == "--native") {
+            compile = true;
+        } else {
+            std::cerr << "Unknown option \"" << option << "\"" << std::endl;
+            return 1;
+        }
+    }
+    std::filesystem::create_directories(directory);
+
+    RunOptions memo;
+    memo.memo_capacity = Memo::default_capacity;
+    RunOptions parallel;
+    parallel.workers = 2;
+    parallel.spawn_cutoff = 2;
+    std::vector<Engine> engines = {
+            emulator("O0", {.opt_level = 0}),
+            emulator("O1", {.opt_level = 1}),
+            emulator("O2", {.opt_level = 2}),
+            emulator("stream", {.stream = true}),
+            emulator("compress", {.opt_level = 2, .compress = true}),
+            emulator("memo", {.opt_level = 2}, memo),
+            emulator("parallel", {.opt_level = 1}, parallel),
+            emulator("profile", {.opt_level = 2, .profile_file = directory + "/case.profile"})
+    };
+    if (compile) {
+        engines.push_back(native());
+    }
+    Fuzzer fuzzer(engines, directory);
+
+    if (not replay.empty()) {
+        std::ifstream file(replay);
+        std::vector<std::string> lines;
+        for (std::string line; std::getline(file, line);) {
+            lines.push_back(line);
+        }
+        auto mismatches = fuzzer.check(lines, read_file(replay + ".in"));
+        for (auto &mismatch: mismatches) {
+            std::cout << mismatch << "\n";
+        }
+        return mismatches.empty() ? 0 : 1;
+    }
+
+    int failures = 0;
+    for (int i = 0; i < iterations; i++) {
+        Generator generator(seed + i);
+        auto lines = generator.program();
+        auto input = generator.input();
+        auto mismatches = fuzzer.check(lines, input);
+        if (mismatches.empty()) {
+            continue;
+        }
+        failures++;
+        std::cout << "Seed " << seed + i << " mismatches:\n";
+        for (auto &mismatch: mismatches) {
+            std::cout << "    " << mismatch << "\n";
+        }
+        auto reduced = fuzzer.minimise(lines, input);
+        auto file_name = directory + "/mismatch_" + std::to_string(seed + i) + ".txt";
+        std::ofstream file(file_name);
+        for (auto &line: reduced) {
+            file << line << '\n';
+        }
+        std::ofstream(file_name + ".in") << input;
+        std::cout << "    reduced from " << lines.size() << " to " << reduced.size() << " lines: " << file_name
+                  << std::endl;
+    }
+    std::cout << iterations << " programs, " << failures << " mismatches, seed " << seed << std::endl;
+    return failures == 0 ? 0 : 1;
+}
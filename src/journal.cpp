@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include "journal.h"
+
+Journal::Journal(eJournal mode, int nodes) : mode_(mode), nodes_(std::max(nodes, 1)) {}
+
+std::unique_ptr<Journal> Journal::read(std::istream &in) {
+    std::string magic;
+    int nodes = 0;
+    if (not(in >> magic >> nodes) || magic != "journal" || nodes < 1) {
+        return nullptr;
+    }
+    auto journal = std::make_unique<Journal>(eJournal::Replay, nodes);
+    Event event{};
+    while (in >> event.kind >> event.node >> event.value) {
+        if ((event.kind != 'i' && event.kind != 'o') || event.node < 0 || event.node >= nodes ||
+            (event.kind == 'o' && event.value <= 0)) {
+            return nullptr;
+        }
+        journal->events_.push_back(event);
+    }
+    return in.eof() ? std::move(journal) : nullptr;
+}
+
+void Journal::write(std::ostream &out) const {
+    std::lock_guard lock(mutex_);
+    out << "journal " << nodes_ << '\n';
+    for (auto &event: events_) {
+        out << event.kind << ' ' << event.node << ' ' << event.value << '\n';
+    }
+}
+
+std::unique_ptr<Journal> Journal::open(eJournal mode, const std::string &file_name, int nodes) {
+    if (mode == eJournal::Record) {
+        return std::make_unique<Journal>(mode, nodes);
+    }
+    std::ifstream file(file_name);
+    if (not file.is_open()) {
+        throw std::runtime_error("Can not open file \"" + file_name + "\"");
+    }
+    auto journal = read(file);
+    if (not journal) {
+        throw std::runtime_error("Journal \"" + file_name + "\" is malformed");
+    }
+    if (journal->nodes_ != std::max(nodes, 1)) {
+        throw std::runtime_error("Journal \"" + file_name + "\" was recorded for " +
+                                 std::to_string(journal->nodes_) + " VMs");
+    }
+    return journal;
+}
+
+void Journal::close(const std::string &file_name) const {
+    if (mode_ == eJournal::Record) {
+        std::ofstream file(file_name);
+        if (not file.is_open()) {
+            throw std::runtime_error("Can not create file \"" + file_name + "\"");
+        }
+        write(file);
+    } else if (diverged()) {
+        throw std::runtime_error("Execution diverged from journal \"" + file_name + "\"");
+    }
+}
+
+int Journal::input(int node, const std::function<void()> &prompt, const std::function<int()> &read) {
+    std::unique_lock lock(mutex_);
+    if (mode_ == eJournal::Record) {
+        int value = read();
+        events_.push_back({node, 'i', value});
+        return value;
+    }
+    if (not claim(node, 'i', lock)) {
+        return read();
+    }
+    int value = events_[head_++].value;
+    turn_.notify_all();
+    prompt();
+    return value;
+}
+
+void Journal::output(int node, const std::function<void()> &write) {
+    if (not ordered()) {
+        write();
+        return;
+    }
+    std::unique_lock lock(mutex_);
+    if (mode_ == eJournal::Record) {
+        if (not events_.empty() && events_.back().kind == 'o' && events_.back().node == node) {
+            events_.back().value++;
+        } else {
+            events_.push_back({node, 'o', 1});
+        }
+    } else if (claim(node, 'o', lock) && ++consumed_ == events_[head_].value) {
+        head_++;
+        consumed_ = 0;
+        turn_.notify_all();
+    }
+    write();
+}
+
+void Journal::finish(int node) {
+    std::lock_guard lock(mutex_);
+    if (mode_ == eJournal::Replay && std::any_of(events_.begin() + static_cast<long>(head_), events_.end(),
+                                                 [node](const Event &event) { return event.node == node; })) {
+        diverge();
+    }
+}
+
+bool Journal::diverged() const {
+    std::lock_guard lock(mutex_);
+    return diverged_;
+}
+
+// Waits until the next recorded event belongs to the node, replay stops enforcing the order once it diverged
+bool Journal::claim(int node, char kind, std::unique_lock<std::mutex> &lock) {
+    turn_.wait(lock, [&] {
+        return diverged_ || head_ >= events_.size() || events_[head_].node == node;
+    });
+    if (diverged_) {
+        return false;
+    }
+    if (head_ >= events_.size() || events_[head_].kind != kind) {
+        diverge();
+        return false;
+    }
+    return true;
+}
+
+void Journal::diverge() {
+    diverged_ = true;
+    turn_.notify_all();
+}
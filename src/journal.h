@@ -0,0 +1,65 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+enum class eJournal {
+    Record, Replay
+};
+
+class Journal {
+public:
+    Journal(eJournal mode, int nodes);
+
+    Journal(const Journal &) = delete;
+
+    Journal &operator=(const Journal &) = delete;
+
+    static std::unique_ptr<Journal> read(std::istream &);
+
+    void write(std::ostream &) const;
+
+    static std::unique_ptr<Journal> open(eJournal, const std::string &, int nodes);
+
+    void close(const std::string &) const;
+
+    int input(int node, const std::function<void()> &prompt, const std::function<int()> &read);
+
+    void output(int node, const std::function<void()> &write);
+
+    void finish(int node);
+
+    [[nodiscard]] eJournal mode() const { return mode_; }
+
+    [[nodiscard]] int nodes() const { return nodes_; }
+
+    [[nodiscard]] bool ordered() const { return nodes_ > 1; }
+
+    [[nodiscard]] bool diverged() const;
+
+private:
+    struct Event {
+        int node;
+        char kind;
+        int value;
+    };
+
+    bool claim(int node, char kind, std::unique_lock<std::mutex> &);
+
+    void diverge();
+
+    eJournal mode_;
+    int nodes_;
+    std::vector<Event> events_;
+    size_t head_ = 0;
+    int consumed_ = 0;
+    bool diverged_ = false;
+    mutable std::mutex mutex_;
+    std::condition_variable turn_;
+};
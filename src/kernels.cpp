@@ -0,0 +1,64 @@
+#include <cstring>
+#include "kernels.h"
+
+#if defined(__AVX2__) || defined(__SSE2__)
+
+#include <immintrin.h>
+
+#endif
+
+void Kernels::copy(int32_t *destination, const int32_t *source, uint32_t count) {
+    // Ranges may overlap, memmove already picks the widest vector copy the target has
+    std::memmove(destination, source, count * sizeof(int32_t));
+}
+
+void Kernels::fill(int32_t *destination, int32_t value, uint32_t count) {
+    uint32_t i = 0;
+#if defined(__AVX2__)
+    auto lanes = _mm256_set1_epi32(value);
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(destination + i), lanes);
+    }
+#elif defined(__SSE2__)
+    auto lanes = _mm_set1_epi32(value);
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + i), lanes);
+    }
+#endif
+    for (; i < count; i++) {
+        destination[i] = value;
+    }
+}
+
+int32_t Kernels::sum(const int32_t *source, uint32_t count) {
+    // Lane adds wrap like the scalar ADD command does
+    uint32_t i = 0;
+    uint32_t total = 0;
+#if defined(__AVX2__)
+    auto first = _mm256_setzero_si256();
+    auto second = _mm256_setzero_si256();
+    for (; i + 16 <= count; i += 16) {
+        first = _mm256_add_epi32(first, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + i)));
+        second = _mm256_add_epi32(second, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + i + 8)));
+    }
+    auto lanes = _mm_add_epi32(_mm256_castsi256_si128(_mm256_add_epi32(first, second)),
+                               _mm256_extracti128_si256(_mm256_add_epi32(first, second), 1));
+#elif defined(__SSE2__)
+    auto first = _mm_setzero_si128();
+    auto second = _mm_setzero_si128();
+    for (; i + 8 <= count; i += 8) {
+        first = _mm_add_epi32(first, _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i)));
+        second = _mm_add_epi32(second, _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i + 4)));
+    }
+    auto lanes = _mm_add_epi32(first, second);
+#endif
+#if defined(__AVX2__) || defined(__SSE2__)
+    alignas(16) uint32_t partial[4];
+    _mm_store_si128(reinterpret_cast<__m128i *>(partial), lanes);
+    total = partial[0] + partial[1] + partial[2] + partial[3];
+#endif
+    for (; i < count; i++) {
+        total += static_cast<uint32_t>(source[i]);
+    }
+    return static_cast<int32_t>(total);
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+
+// Bulk kernels over the linear memory, vectorised where the target has SSE2 or AVX2
+namespace Kernels {
+    void copy(int32_t *destination, const int32_t *source, uint32_t count);
+
+    void fill(int32_t *destination, int32_t value, uint32_t count);
+
+    int32_t sum(const int32_t *source, uint32_t count);
+}
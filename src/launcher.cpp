@@ -0,0 +1,127 @@
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include "exc.h"
+#include "launcher.h"
+
+Launcher::Launcher(const std::string &config_name) {
+    std::ifstream file(config_name);
+    if (not file.is_open()) {
+        throw std::runtime_error("File is closed");
+    }
+    struct Link {
+        int from, send, to, recv;
+        uint32_t capacity;
+    };
+    std::vector<Link> links;
+    std::string line;
+    for (int line_number = 1; std::getline(file, line); line_number++) {
+        std::stringstream stream(line.substr(0, line.find("//")));
+        std::string kind;
+        stream >> kind;
+        if (kind.empty()) {
+            continue;
+        }
+        if (kind == "vm") {
+            Node node;
+            stream >> node.name >> node.file_name;
+            if (node.file_name.empty()) {
+                throw InvalidArgumentException("Expected \"vm <name> <file>\"", line_number);
+            }
+            if (not index_.emplace(node.name, static_cast<int>(nodes_.size())).second) {
+                throw InvalidArgumentException("VM \"" + node.name + "\" is already defined", line_number);
+            }
+            nodes_.push_back(std::move(node));
+        } else if (kind == "channel") {
+            std::string from, to;
+            Link link{-1, -1, -1, -1, Channel::default_capacity};
+            stream >> from >> link.send >> to >> link.recv;
+            if (not stream || link.send < 0 || link.recv < 0) {
+                throw InvalidArgumentException("Expected \"channel <vm> <send> <vm> <recv> [capacity]\"",
+                                               line_number);
+            }
+            if (stream >> link.capacity; link.capacity == 0) {
+                throw InvalidArgumentException("Channel capacity must be positive", line_number);
+            }
+            for (auto &name: {from, to}) {
+                if (not index_.contains(name)) {
+                    throw InvalidArgumentException("Unknown VM \"" + name + "\"", line_number);
+                }
+            }
+            link.from = index_[from];
+            link.to = index_[to];
+            for (auto &other: links) {
+                if ((other.from == link.from && other.send == link.send) ||
+                    (other.to == link.to && other.recv == link.recv)) {
+                    throw InvalidArgumentException("Channel endpoint is already connected", line_number);
+                }
+            }
+            links.push_back(link);
+        } else {
+            throw InvalidArgumentException("Unknown directive \"" + kind + "\"", line_number);
+        }
+    }
+    board_ = std::make_unique<Switchboard>(static_cast<int>(nodes_.size()));
+    for (auto &node: nodes_) {
+        node.channels = std::make_unique<Channels>(board_.get());
+    }
+    for (auto &link: links) {
+        auto &channel = channels_.emplace_back(std::make_unique<Channel>(link.capacity));
+        nodes_[link.from].channels->connect(link.send, channel.get(), true);
+        nodes_[link.to].channels->connect(link.recv, channel.get(), false);
+    }
+}
+
+int Launcher::run(Journal *journal) {
+    journal_ = journal;
+    RunOptions options;
+    if (journal_) {
+        options.workers = 0;
+    }
+    for (int i = 0; i < nodes_.size(); i++) {
+        auto &node = nodes_[i];
+        node.vm = std::make_unique<CPUEmulator>(node.file_name);
+        node.vm->start(options);
+        node.vm->context().channels = node.channels.get();
+        node.vm->context().journal = journal_;
+        node.vm->context().node = i;
+        CPUEmulator::clear();
+    }
+    std::vector<std::thread> threads;
+    threads.reserve(nodes_.size());
+    for (int i = 0; i < nodes_.size(); i++) {
+        threads.emplace_back(&Launcher::execute, this, i);
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    int failed = 0;
+    for (auto &node: nodes_) {
+        if (node.trap.fault()) {
+            std::cerr << node.name << ": ";
+            CPUEmulator::report(node.trap);
+            failed++;
+        }
+        node.vm.reset();
+    }
+    return failed;
+}
+
+void Launcher::execute(int id) {
+    auto &node = nodes_[id];
+    Trap trap;
+    while ((trap = node.vm->resume()).kind == eTrap::Blocked) {
+        auto [command, channel] = node.vm->program()[trap.pc];
+        bool sending = command == eCommands::Send;
+        auto *endpoint = sending ? node.channels->sender(channel) : node.channels->receiver(channel);
+        if (not board_->wait(id, endpoint, sending)) {
+            trap.kind = eTrap::Deadlock;
+            break;
+        }
+    }
+    board_->finish(id);
+    if (journal_) {
+        journal_->finish(id);
+    }
+    node.trap = trap;
+}
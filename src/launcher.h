@@ -0,0 +1,36 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "channel.h"
+#include "cpu.h"
+
+class Launcher {
+public:
+    explicit Launcher(const std::string &config_name);
+
+    int run(Journal *journal = nullptr);
+
+    [[nodiscard]] int size() const { return static_cast<int>(nodes_.size()); }
+
+    [[nodiscard]] const Trap &trap(const std::string &name) const { return nodes_[index_.at(name)].trap; }
+
+private:
+    struct Node {
+        std::string name;
+        std::string file_name;
+        std::unique_ptr<CPUEmulator> vm;
+        std::unique_ptr<Channels> channels;
+        Trap trap;
+    };
+
+    void execute(int);
+
+    std::vector<Node> nodes_;
+    std::map<std::string, int> index_;
+    std::vector<std::unique_ptr<Channel>> channels_;
+    std::unique_ptr<Switchboard> board_;
+    Journal *journal_ = nullptr;
+};
@@ -0,0 +1,219 @@
+#include <algorithm>
+#include <numeric>
+#include <set>
+#include "layout.h"
+
+namespace {
+    bool is_pseudo(eCommands command) {
+        return command == eCommands::Blank || command == eCommands::Label;
+    }
+
+    enum class eExit {
+        Keep, Invert, Drop, Jump
+    };
+}
+
+Profile Layout::read(std::istream &in) {
+    Profile profile;
+    int line;
+    EdgeCounts counts;
+    while (in >> line >> counts.count >> counts.taken) {
+        auto &total = profile[line];
+        total.count += counts.count;
+        total.taken += counts.taken;
+    }
+    return profile;
+}
+
+void Layout::write(std::ostream &out, const Profile &profile) {
+    for (auto &[line, counts]: profile) {
+        out << line << ' ' << counts.count << ' ' << counts.taken << '\n';
+    }
+}
+
+eCommands Layout::invert(eCommands command) {
+    switch (command) {
+        case eCommands::JumpE:
+            return eCommands::JumpNE;
+        case eCommands::JumpNE:
+            return eCommands::JumpE;
+        case eCommands::JumpG:
+            return eCommands::JumpLE;
+        case eCommands::JumpLE:
+            return eCommands::JumpG;
+        case eCommands::JumpGE:
+            return eCommands::JumpL;
+        case eCommands::JumpL:
+            return eCommands::JumpGE;
+        default:
+            return command;
+    }
+}
+
+EdgeCounts Layout::counts_of(const Statement &statement) const {
+    auto it = profile_.find(statement.line);
+    return it == profile_.end() ? EdgeCounts{} : it->second;
+}
+
+void Layout::run(std::vector<Statement> &program) const {
+    // Block order decides which of several definitions of a label wins, keep such programs as written
+    std::set<std::string> names;
+    for (auto &statement: program) {
+        if (statement.command == eCommands::Label && not names.insert(statement.param).second) {
+            return;
+        }
+    }
+    ControlFlowGraph cfg(program);
+    auto &blocks = cfg.blocks();
+    int size = static_cast<int>(blocks.size());
+    if (size < 2) {
+        return;
+    }
+
+    std::vector<uint64_t> heat(size, 0);
+    std::vector<int> last(size);
+    std::vector<int> fallthrough(size, -1);
+    struct Arc {
+        int from;
+        int to;
+        uint64_t weight;
+        bool forced;
+    };
+    std::vector<Arc> arcs;
+    for (int id = 0; id < size; id++) {
+        int first = blocks[id].begin;
+        while (first < program.size() && is_pseudo(program[first].command)) {
+            first++;
+        }
+        heat[id] = first < program.size() ? counts_of(program[first]).count : 0;
+        last[id] = blocks[id].end - 1;
+        while (last[id] > blocks[id].begin && program[last[id]].command == eCommands::Blank) {
+            last[id]--;
+        }
+        auto &statement = program[last[id]];
+        auto counts = is_pseudo(statement.command) ? EdgeCounts{heat[id], 0} : counts_of(statement);
+        for (auto &edge: blocks[id].successors) {
+            if (edge.kind == eEdge::Fallthrough) {
+                fallthrough[id] = edge.to;
+                bool conditional = ControlFlowGraph::is_conditional(statement.command);
+                uint64_t weight = conditional ? counts.count - std::min(counts.taken, counts.count) : counts.count;
+                arcs.push_back({id, edge.to, weight, statement.command == eCommands::Call});
+            } else if (edge.kind != eEdge::Call) {
+                arcs.push_back({id, edge.to, edge.kind == eEdge::Branch ? counts.taken : counts.count, false});
+            }
+        }
+    }
+
+    // A block that can run off the end of the program has to stay last
+    int sink = -1;
+    auto tail = program[last[size - 1]].command;
+    if (tail != eCommands::Jump && tail != eCommands::Ret && tail != eCommands::End) {
+        sink = size - 1;
+    }
+
+    std::vector<int> next(size, -1);
+    std::vector<int> previous(size, -1);
+    std::vector<int> chain(size);
+    std::iota(chain.begin(), chain.end(), 0);
+    auto find = [&chain](int id) {
+        while (chain[id] != id) {
+            id = chain[id] = chain[chain[id]];
+        }
+        return id;
+    };
+    std::stable_sort(arcs.begin(), arcs.end(), [](const Arc &a, const Arc &b) {
+        return a.forced != b.forced ? a.forced : a.weight > b.weight;
+    });
+    for (auto &arc: arcs) {
+        if ((not arc.forced && arc.weight == 0) || arc.from == sink || next[arc.from] != -1 ||
+            previous[arc.to] != -1 || find(arc.from) == find(arc.to)) {
+            continue;
+        }
+        next[arc.from] = arc.to;
+        previous[arc.to] = arc.from;
+        chain[find(arc.to)] = find(arc.from);
+    }
+
+    struct Chain {
+        int head;
+        uint64_t heat;
+        bool sink;
+    };
+    std::vector<Chain> chains;
+    for (int id = 0; id < size; id++) {
+        if (previous[id] == -1) {
+            chains.push_back({id, 0, false});
+            for (int member = id; member != -1; member = next[member]) {
+                chains.back().heat = std::max(chains.back().heat, heat[member]);
+                chains.back().sink = chains.back().sink || member == sink;
+            }
+        }
+    }
+    // Hot chains keep their source order, code that ran at most once goes after them
+    std::stable_sort(chains.begin(), chains.end(), [](const Chain &a, const Chain &b) {
+        if (a.sink != b.sink) {
+            return b.sink;
+        }
+        return (a.heat > 1) > (b.heat > 1);
+    });
+    std::vector<int> order;
+    for (auto &item: chains) {
+        for (int member = item.head; member != -1; member = next[member]) {
+            order.push_back(member);
+        }
+    }
+
+    std::vector<eExit> exits(size, eExit::Keep);
+    std::vector<bool> needs_label(size, false);
+    for (int k = 0; k < size; k++) {
+        int id = order[k];
+        int placed = k + 1 < size ? order[k + 1] : -1;
+        auto &statement = program[last[id]];
+        int target = ControlFlowGraph::is_jump(statement.command) ? cfg.label_index(statement.param) : -1;
+        int taken = target == -1 ? -1 : cfg.block_of(target);
+        if (fallthrough[id] != -1 && fallthrough[id] != placed) {
+            bool invert = ControlFlowGraph::is_conditional(statement.command) && taken == placed;
+            exits[id] = invert ? eExit::Invert : eExit::Jump;
+            needs_label[fallthrough[id]] = true;
+        } else if (statement.command == eCommands::Jump && taken != -1 && taken == placed) {
+            exits[id] = eExit::Drop;
+        }
+    }
+
+    std::vector<std::string> label(size);
+    int fresh = 0;
+    for (int id = 0; id < size; id++) {
+        if (program[blocks[id].begin].command == eCommands::Label) {
+            label[id] = program[blocks[id].begin].param;
+        } else if (needs_label[id]) {
+            do {
+                label[id] = "pgo" + std::to_string(fresh++);
+            } while (names.contains(label[id]));
+        }
+    }
+
+    std::vector<Statement> result;
+    result.reserve(program.size() + size);
+    for (int id: order) {
+        auto &block = blocks[id];
+        if (needs_label[id] && program[block.begin].command != eCommands::Label) {
+            result.push_back({eCommands::Label, label[id], program[block.begin].line});
+        }
+        for (int i = block.begin; i < block.end; i++) {
+            auto statement = program[i];
+            if (i == last[id] && exits[id] == eExit::Drop) {
+                continue;
+            }
+            if (i == last[id] && exits[id] == eExit::Invert) {
+                statement.command = invert(statement.command);
+                statement.param = label[fallthrough[id]];
+            }
+            result.push_back(std::move(statement));
+        }
+        if (exits[id] == eExit::Jump) {
+            auto &exit = program[last[id]];
+            result.push_back({eCommands::Jump, label[fallthrough[id]], exit.line, exit.column});
+        }
+    }
+    program = std::move(result);
+}
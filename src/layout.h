@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <vector>
+#include "cfg.h"
+
+struct EdgeCounts {
+    uint64_t count = 0;
+    uint64_t taken = 0;
+};
+
+using Profile = std::map<int, EdgeCounts>;
+
+class Layout {
+public:
+    explicit Layout(Profile profile) : profile_(std::move(profile)) {}
+
+    void run(std::vector<Statement> &) const;
+
+    static Profile read(std::istream &);
+
+    static void write(std::ostream &, const Profile &);
+
+    static eCommands invert(eCommands);
+
+private:
+    [[nodiscard]] EdgeCounts counts_of(const Statement &) const;
+
+    Profile profile_;
+};
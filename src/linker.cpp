@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <stdexcept>
+#include "linker.h"
+
+std::vector<Statement> Linker::run(const std::vector<std::string> &modules) {
+    modules_.clear();
+    exports_.clear();
+    names_.clear();
+    modules_.reserve(modules.size());
+    for (auto &name: modules) {
+        modules_.push_back({name});
+        modules_.back().parser.parse_binary(name);
+        // The pre-evaluated output, registers and stacks have no statement form to append
+        if (modules_.back().parser.get_state()) {
+            throw std::runtime_error("\"" + name + "\" was partially evaluated at build time, rebuild it with "
+                                     "--eval-budget=0 to link it");
+        }
+    }
+    resolve();
+    std::vector<Statement> statements;
+    for (auto &module: modules_) {
+        append(module, statements);
+    }
+    return statements;
+}
+
+void Linker::resolve() {
+    std::string entry;
+    for (size_t i = 0; i < modules_.size(); i++) {
+        auto &parser = modules_[i].parser;
+        for (auto &[command, param]: parser.get_raw_program()) {
+            if (ControlFlowGraph::is_jump(command)) {
+                names_.insert(param);
+            }
+            if (command != eCommands::Begin) {
+                continue;
+            }
+            if (not entry.empty()) {
+                throw std::runtime_error("BEGIN command appears in both \"" + entry + "\" and \"" +
+                                         modules_[i].name + "\"");
+            }
+            entry = modules_[i].name;
+        }
+        for (auto &[name, pc]: parser.get_symbols()) {
+            names_.insert(name);
+        }
+        std::vector<std::string> exported = parser.get_exports();
+        if (not parser.module()) {
+            for (auto &[name, pc]: parser.get_symbols()) {
+                exported.push_back(name);
+            }
+        }
+        std::sort(exported.begin(), exported.end());
+        exported.erase(std::unique(exported.begin(), exported.end()), exported.end());
+        for (auto &name: exported) {
+            auto [it, inserted] = exports_.emplace(name, i);
+            if (not inserted) {
+                throw std::runtime_error("Label \"" + name + "\" is exported by both \"" +
+                                         modules_[it->second].name + "\" and \"" + modules_[i].name + "\"");
+            }
+        }
+    }
+    for (size_t i = 0; i < modules_.size(); i++) {
+        auto &module = modules_[i];
+        for (auto &name: module.parser.get_imports()) {
+            if (not exports_.contains(name)) {
+                throw std::runtime_error("Label \"" + name + "\" imported by \"" + module.name +
+                                         "\" is not exported by any module");
+            }
+        }
+        for (auto &[name, pc]: module.parser.get_symbols()) {
+            auto it = exports_.find(name);
+            if ((it != exports_.end() && it->second == i) || module.locals.contains(name)) {
+                continue;
+            }
+            auto local = name + "M" + std::to_string(i);
+            while (names_.contains(local)) {
+                local += "M";
+            }
+            names_.insert(local);
+            module.locals.emplace(name, local);
+        }
+    }
+}
+
+void Linker::append(Module &module, std::vector<Statement> &statements) const {
+    auto &parser = module.parser;
+    auto program = parser.get_raw_program();
+    auto &debug = parser.get_debug();
+    auto rename = [&module](const std::string &name) {
+        auto it = module.locals.find(name);
+        return it == module.locals.end() ? name : it->second;
+    };
+    std::vector<std::pair<int, std::string>> labels;
+    for (auto &[name, pc]: parser.get_symbols()) {
+        labels.emplace_back(pc, name);
+    }
+    std::stable_sort(labels.begin(), labels.end(), [](auto &a, auto &b) { return a.first < b.first; });
+    auto label = labels.begin();
+    for (int pc = 0; pc <= program.size(); pc++) {
+        DebugLine line{parser.stripped() ? -1 : pc + 1, 0, -1};
+        if (pc < debug.size()) {
+            line = debug[pc];
+        }
+        for (; label != labels.end() && (label->first <= pc || pc == program.size()); ++label) {
+            statements.push_back({eCommands::Label, rename(label->second), line.line, 0});
+        }
+        if (pc == program.size()) {
+            break;
+        }
+        auto &[command, param] = program[pc];
+        statements.push_back({command, ControlFlowGraph::is_jump(command) ? rename(param) : param, line.line,
+                              line.column});
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "cfg.h"
+
+class Linker {
+public:
+    Linker() = default;
+
+    std::vector<Statement> run(const std::vector<std::string> &modules);
+
+private:
+    struct Module {
+        std::string name;
+        Parser parser;
+        std::map<std::string, std::string> locals;
+    };
+
+    void resolve();
+
+    void append(Module &, std::vector<Statement> &) const;
+
+    std::vector<Module> modules_;
+    std::map<std::string, size_t> exports_;
+    std::set<std::string> names_;
+};
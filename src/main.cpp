@@ -1,15 +1,184 @@
+#include <filesystem>
 #include <iostream>
+#include <sstream>
 #include "cpu.h"
+#include "debugger.h"
+#include "launcher.h"
 
 int main(int argc, char **argv) {
-    if (argc != 3) {
+    if (argc < 3) {
         return 0;
     }
     CPUEmulator app(argv[2]);
-    if (std::string(argv[1]) == "build") {
-        app.build(argv[2]);
-    } else if (std::string(argv[1]) == "run") {
-        app.run();
+    std::string command = argv[1];
+    if (command == "build" || command == "link") {
+        BuildOptions options;
+        std::vector<std::string> modules;
+        for (int i = 3; i < argc; i++) {
+            std::string option = argv[i];
+            if (command == "link" && not option.starts_with('-')) {
+                modules.push_back(option);
+            } else if (option == "--dump-cfg") {
+                options.dump_cfg = true;
+            } else if (option == "--strip") {
+                options.strip = true;
+            } else if (option == "--stream") {
+                options.stream = true;
+            } else if (option == "--compress") {
+                options.compress = true;
+            } else if (option == "--module" && command == "build") {
+                options.module = true;
+            } else if (option.starts_with("--export=") && command == "build") {
+                std::stringstream names(option.substr(option.find('=') + 1));
+                std::string name;
+                while (std::getline(names, name, ',')) {
+                    options.exports.push_back(name);
+                }
+            } else if (option == "--emit-c") {
+                options.emit_c = true;
+            } else if (option == "--native") {
+                options.emit_c = options.native = true;
+            } else if (option.starts_with("--native=")) {
+                options.emit_c = options.native = true;
+                options.native_file = option.substr(option.find('=') + 1);
+            } else if (option.starts_with("--profile-in=")) {
+                options.profile_file = option.substr(option.find('=') + 1);
+            } else if (option.starts_with("--inline-budget=")) {
+                options.inline_budget = std::stoi(option.substr(option.find('=') + 1));
+            } else if (option.starts_with("--eval-budget=")) {
+                options.eval_budget = std::stoi(option.substr(option.find('=') + 1));
+            } else if (option.starts_with("-O") && option.size() == 3 && isdigit(option[2])) {
+                options.opt_level = option[2] - '0';
+            } else {
+                std::cerr << "Unknown option \"" << option << "\"" << std::endl;
+                return 1;
+            }
+        }
+        if (options.stream && (options.compress || options.module || not options.profile_file.empty())) {
+            std::cerr << "Option \"--stream\" can not be combined with \"--compress\", \"--module\" or "
+                         "\"--profile-in\"" << std::endl;
+            return 1;
+        }
+        if (not options.exports.empty()) {
+            options.module = true;
+        }
+        if (options.emit_c && (options.stream || options.module)) {
+            std::cerr << "Option \"--emit-c\" can not be combined with \"--stream\" or \"--module\"" << std::endl;
+            return 1;
+        }
+        if (options.native && options.native_file.empty()) {
+            // The executable is named after the source without its extension, never the source itself
+            std::filesystem::path executable(argv[2]);
+            executable.replace_extension();
+            options.native_file = executable.string() == argv[2] ? executable.string() + ".out" : executable.string();
+        }
+        if (command == "build") {
+            app.build(argv[2], options);
+        } else {
+            app.link(modules, options);
+        }
+    } else if (command == "launch") {
+        std::string record;
+        std::string replay;
+        for (int i = 3; i < argc; i++) {
+            std::string option = argv[i];
+            if (option.starts_with("--record=")) {
+                record = option.substr(option.find('=') + 1);
+            } else if (option.starts_with("--replay=")) {
+                replay = option.substr(option.find('=') + 1);
+            } else {
+                std::cerr << "Unknown option \"" << option << "\"" << std::endl;
+                return 1;
+            }
+        }
+        if (not record.empty() && not replay.empty()) {
+            std::cerr << "Option \"--record\" can not be combined with \"--replay\"" << std::endl;
+            return 1;
+        }
+        try {
+            Launcher launcher(argv[2]);
+            std::unique_ptr<Journal> journal;
+            if (not record.empty() || not replay.empty()) {
+                journal = Journal::open(replay.empty() ? eJournal::Record : eJournal::Replay,
+                                        replay.empty() ? record : replay, launcher.size());
+            }
+            int failed = launcher.run(journal.get());
+            if (journal) {
+                journal->close(replay.empty() ? record : replay);
+            }
+            return failed == 0 ? 0 : 1;
+        } catch (InvalidArgumentException &e) {
+            std::cerr << "Error in line " << e.line() << ": " << e.what() << std::endl;
+            return 1;
+        } catch (std::runtime_error &e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    } else if (command == "run") {
+        RunOptions options;
+        std::string script;
+        bool debug = false;
+        for (int i = 3; i < argc; i++) {
+            std::string option = argv[i];
+            if (option == "--debug") {
+                debug = true;
+            } else if (option.starts_with("--debug=")) {
+                debug = true;
+                script = option.substr(option.find('=') + 1);
+            } else if (option.starts_with("--metrics=")) {
+                options.metrics_file = option.substr(option.find('=') + 1);
+            } else if (option == "--metrics-format=json") {
+                options.metrics_format = eMetricsFormat::Json;
+            } else if (option == "--metrics-format=prometheus") {
+                options.metrics_format = eMetricsFormat::Prometheus;
+            } else if (option.starts_with("--metrics-interval=")) {
+                options.metrics_interval = std::stoi(option.substr(option.find('=') + 1));
+            } else if (option == "--perf-counters") {
+                options.perf_counters = true;
+            } else if (option == "--perf-counters=opcodes") {
+                options.perf_counters = true;
+                options.perf_sample_period = options.perf_sample_period > 0 ? options.perf_sample_period : 1000;
+            } else if (option == "--memo") {
+                options.memo_capacity = Memo::default_capacity;
+            } else if (option.starts_with("--memo=")) {
+                options.memo_capacity = std::stoul(option.substr(option.find('=') + 1));
+            } else if (option.starts_with("--profile-out=")) {
+                options.profile_file = option.substr(option.find('=') + 1);
+            } else if (option.starts_with("--workers=")) {
+                options.workers = std::stoi(option.substr(option.find('=') + 1));
+            } else if (option.starts_with("--spawn-cutoff=")) {
+                options.spawn_cutoff = std::stoul(option.substr(option.find('=') + 1));
+            } else if (option.starts_with("--cost-model=")) {
+                options.cost_model = option.substr(option.find('=') + 1);
+            } else if (option.starts_with("--cost-report=")) {
+                options.cost_report = option.substr(option.find('=') + 1);
+            } else if (option.starts_with("--record=")) {
+                options.record_file = option.substr(option.find('=') + 1);
+            } else if (option.starts_with("--replay=")) {
+                options.replay_file = option.substr(option.find('=') + 1);
+            } else if (option.starts_with("--perf-sample-period=")) {
+                options.perf_sample_period = std::stoi(option.substr(option.find('=') + 1));
+            } else {
+                std::cerr << "Unknown option \"" << option << "\"" << std::endl;
+                return 1;
+            }
+        }
+        if (not options.record_file.empty() && not options.replay_file.empty()) {
+            std::cerr << "Option \"--record\" can not be combined with \"--replay\"" << std::endl;
+            return 1;
+        }
+        if (not debug) {
+            app.run(options);
+        } else if (script.empty()) {
+            Debugger(app, std::cin, std::cout).run();
+        } else {
+            std::ifstream commands(script);
+            if (not commands.is_open()) {
+                std::cerr << "Can not open file \"" << script << "\"" << std::endl;
+                return 1;
+            }
+            Debugger(app, commands, std::cout).run();
+        }
     }
     return 0;
-}
\ No newline at end of file
+}
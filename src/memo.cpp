@@ -0,0 +1,87 @@
+#include "memo.h"
+
+Memo::Memo(const std::vector<PureSubroutine> &subroutines, size_t capacity) : capacity_(capacity) {
+    for (auto &subroutine: subroutines) {
+        subroutines_[subroutine.entry] = subroutine;
+    }
+}
+
+size_t Memo::KeyHash::operator()(const std::vector<int> &key) const {
+    size_t hash = key.size();
+    for (auto value: key) {
+        hash ^= static_cast<uint32_t>(value) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    }
+    return hash;
+}
+
+std::optional<int> Memo::enter(int target, int line, Context *context) {
+    auto it = subroutines_.find(target);
+    if (it == subroutines_.end() || context->data.size() < it->second.pops) {
+        return std::nullopt;
+    }
+    auto &subroutine = it->second;
+    std::vector<int> key{target};
+    for (int reg = 0; reg < RegisterType::available.size(); reg++) {
+        if (subroutine.inputs & (1u << reg)) {
+            key.push_back(context->registers[reg]);
+        }
+    }
+    uint32_t depth = context->data.size();
+    for (uint32_t i = depth - subroutine.pops; i < depth; i++) {
+        key.push_back(context->data.at(i));
+    }
+
+    auto cached = cache_.find(key);
+    if (cached == cache_.end() || context->data.capacity() - depth + subroutine.pops < subroutine.pushes) {
+        misses_++;
+        pending_.push_back({&subroutine, std::move(key), context->call.size()});
+        return std::nullopt;
+    }
+    hits_++;
+    auto value = cached->second.begin();
+    for (int reg = 0; reg < RegisterType::available.size(); reg++) {
+        if (subroutine.outputs & (1u << reg)) {
+            context->registers[reg] = *value++;
+        }
+    }
+    for (int i = 0; i < subroutine.pops; i++) {
+        context->data.pop();
+    }
+    for (; value != cached->second.end(); value++) {
+        context->data.push(*value);
+    }
+    return line + 1;
+}
+
+void Memo::leave(Context *context) {
+    if (pending_.empty() || pending_.back().depth != context->call.size()) {
+        return;
+    }
+    auto pending = std::move(pending_.back());
+    pending_.pop_back();
+    auto &subroutine = *pending.subroutine;
+    if (context->data.size() < subroutine.pushes) {
+        return;
+    }
+    std::vector<int> result;
+    for (int reg = 0; reg < RegisterType::available.size(); reg++) {
+        if (subroutine.outputs & (1u << reg)) {
+            result.push_back(context->registers[reg]);
+        }
+    }
+    uint32_t depth = context->data.size();
+    for (uint32_t i = depth - subroutine.pushes; i < depth; i++) {
+        result.push_back(context->data.at(i));
+    }
+    if (capacity_ == 0) {
+        return;
+    }
+    if (cache_.size() >= capacity_) {
+        cache_.erase(cache_.begin());
+    }
+    cache_.emplace(std::move(pending.key), std::move(result));
+}
+
+void Memo::report(std::ostream &out) const {
+    out << "memo: hits=" << hits_ << " misses=" << misses_ << " entries=" << cache_.size() << std::endl;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+#include "context.h"
+
+struct PureSubroutine {
+    int32_t entry = -1;
+    int32_t pops = 0;
+    int32_t pushes = 0;
+    uint32_t inputs = 0;
+    uint32_t outputs = 0;
+};
+
+class Memo {
+public:
+    static constexpr size_t default_capacity = 4096;
+
+    Memo(const std::vector<PureSubroutine> &subroutines, size_t capacity);
+
+    std::optional<int> enter(int target, int line, Context *context);
+
+    void leave(Context *context);
+
+    [[nodiscard]] uint64_t hits() const { return hits_; }
+
+    [[nodiscard]] uint64_t misses() const { return misses_; }
+
+    [[nodiscard]] size_t size() const { return cache_.size(); }
+
+    void report(std::ostream &) const;
+
+private:
+    struct KeyHash {
+        size_t operator()(const std::vector<int> &) const;
+    };
+
+    struct Pending {
+        const PureSubroutine *subroutine;
+        std::vector<int> key;
+        uint32_t depth;
+    };
+
+    std::unordered_map<int, PureSubroutine> subroutines_;
+    std::unordered_map<std::vector<int>, std::vector<int>, KeyHash> cache_;
+    std::vector<Pending> pending_;
+    size_t capacity_;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+};
@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include "metrics.h"
+
+namespace {
+    const std::array<std::string, static_cast<size_t>(ePhase::IO) + 1> phase_name = {
+            "parse", "configure", "execute", "io"
+    };
+
+    double seconds(Metrics::clock::duration duration) {
+        return std::chrono::duration<double>(duration).count();
+    }
+}
+
+void Metrics::merge(const Metrics &other) {
+    for (size_t i = 0; i < retired.size(); i++) {
+        retired[i] += other.retired[i];
+    }
+    for (size_t i = 0; i < phases.size(); i++) {
+        phases[i] += other.phases[i];
+    }
+    peak_data = std::max(peak_data, other.peak_data);
+    peak_call = std::max(peak_call, other.peak_call);
+}
+
+uint64_t Metrics::total_retired() const {
+    uint64_t total = 0;
+    for (auto count: retired) {
+        total += count;
+    }
+    return total;
+}
+
+void Metrics::write(std::ostream &out, eMetricsFormat format) const {
+    double execute = seconds(phases[static_cast<size_t>(ePhase::Execute)]);
+    double ips = execute > 0 ? static_cast<double>(total_retired()) / execute : 0;
+    if (format == eMetricsFormat::Json) {
+        out << "{\n  \"instructions_retired\": " << total_retired() << ",\n";
+        out << "  \"instructions_per_second\": " << ips << ",\n";
+        out << "  \"retired_by_opcode\": {";
+        bool first = true;
+        for (size_t i = 0; i < retired.size(); i++) {
+            if (retired[i] != 0) {
+                out << (first ? "" : ",") << "\n    \"" << command_name.at(static_cast<eCommands>(i)) << "\": "
+                    << retired[i];
+                first = false;
+            }
+        }
+        out << (first ? "" : "\n  ") << "},\n";
+        out << "  \"peak_data_depth\": " << peak_data << ",\n";
+        out << "  \"peak_call_depth\": " << peak_call << ",\n";
+        out << "  \"phase_seconds\": {";
+        for (size_t i = 0; i < phases.size(); i++) {
+            out << (i == 0 ? "" : ",") << "\n    \"" << phase_name[i] << "\": " << seconds(phases[i]);
+        }
+        out << "\n  }\n}\n";
+        return;
+    }
+    out << "# TYPE emulator_instructions_retired_total counter\n";
+    for (size_t i = 0; i < retired.size(); i++) {
+        if (retired[i] != 0) {
+            out << "emulator_instructions_retired_total{opcode=\"" << command_name.at(static_cast<eCommands>(i))
+                << "\"} " << retired[i] << '\n';
+        }
+    }
+    out << "# TYPE emulator_instructions_per_second gauge\n";
+    out << "emulator_instructions_per_second " << ips << '\n';
+    out << "# TYPE emulator_peak_stack_depth gauge\n";
+    out << "emulator_peak_stack_depth{stack=\"data\"} " << peak_data << '\n';
+    out << "emulator_peak_stack_depth{stack=\"call\"} " << peak_call << '\n';
+    out << "# TYPE emulator_phase_seconds_total counter\n";
+    for (size_t i = 0; i < phases.size(); i++) {
+        out << "emulator_phase_seconds_total{phase=\"" << phase_name[i] << "\"} " << seconds(phases[i]) << '\n';
+    }
+}
+
+Metrics &MetricsRegistry::local() {
+    thread_local Metrics metrics;
+    return metrics;
+}
+
+void MetricsRegistry::flush() {
+    auto &metrics = local();
+    std::lock_guard lock(mutex_);
+    total_.merge(metrics);
+    metrics = Metrics();
+}
+
+Metrics MetricsRegistry::snapshot() {
+    std::lock_guard lock(mutex_);
+    auto metrics = total_;
+    metrics.merge(local());
+    return metrics;
+}
+
+void MetricsRegistry::reset() {
+    std::lock_guard lock(mutex_);
+    total_ = Metrics();
+    local() = Metrics();
+}
+
+void MetricsRegistry::export_to(const std::string &file_name, eMetricsFormat format) {
+    std::ofstream file(file_name, std::ios::out | std::ios::trunc);
+    if (not file.is_open()) {
+        std::cerr << "Can not create file \"" + file_name + "\"" << std::endl;
+        return;
+    }
+    snapshot().write(file, format);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include "commands.h"
+
+enum class ePhase : uint8_t {
+    Parse = 0, Configure, Execute, IO
+};
+
+enum class eMetricsFormat {
+    Json, Prometheus
+};
+
+struct Metrics {
+    using clock = std::chrono::steady_clock;
+
+    std::array<uint64_t, command_count> retired{};
+    std::array<clock::duration, static_cast<size_t>(ePhase::IO) + 1> phases{};
+    uint32_t peak_data = 0;
+    uint32_t peak_call = 0;
+
+    void merge(const Metrics &);
+
+    [[nodiscard]] uint64_t total_retired() const;
+
+    void write(std::ostream &, eMetricsFormat) const;
+};
+
+class MetricsRegistry {
+public:
+    static Metrics &local();
+
+    static void flush();
+
+    static Metrics snapshot();
+
+    static void reset();
+
+    static void export_to(const std::string &, eMetricsFormat);
+
+private:
+    static inline std::mutex mutex_;
+    static inline Metrics total_;
+};
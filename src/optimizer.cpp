@@ -0,0 +1,289 @@
+#include <map>
+#include <set>
+#include "optimizer.h"
+
+namespace {
+    int all_registers() {
+        return (1 << RegisterType::available.size()) - 1;
+    }
+
+    int register_bit(const std::string &name) {
+        int index = RegisterType::index(name);
+        return index == -1 ? 0 : 1 << index;
+    }
+
+    int live_before(const Statement &statement, int live, const ControlFlowGraph &cfg) {
+        switch (statement.command) {
+            case eCommands::PushR:
+            case eCommands::LoadR:
+            case eCommands::StoreR:
+                return live | register_bit(statement.param);
+            case eCommands::PopR:
+                return live & ~register_bit(statement.param);
+            case eCommands::Call:
+            case eCommands::Ret:
+            case eCommands::Spawn:
+                return all_registers();
+            case eCommands::End:
+                return 0;
+            default:
+                if (ControlFlowGraph::is_jump(statement.command) && cfg.label_index(statement.param) == -1) {
+                    return all_registers();
+                }
+                return live;
+        }
+    }
+
+    bool is_push(eCommands command) {
+        return command == eCommands::Push || command == eCommands::PushR;
+    }
+}
+
+void Optimizer::run(std::vector<Statement> &program) const {
+    if (level_ < 1) {
+        return;
+    }
+    replace_tail_calls(program);
+    if (level_ >= 2) {
+        inline_calls(program, inline_budget_);
+    }
+    remove_unreachable(program);
+    while (remove_dead_stores(program)) {}
+}
+
+void Optimizer::remove_unreachable(std::vector<Statement> &program) {
+    ControlFlowGraph cfg(program);
+    if (cfg.entry() == -1) {
+        return;
+    }
+    std::set<std::string> referenced;
+    for (int i = 0; i < program.size(); i++) {
+        if (cfg.reachable(i) && ControlFlowGraph::is_jump(program[i].command)) {
+            referenced.insert(program[i].param);
+        }
+    }
+    std::vector<Statement> result;
+    result.reserve(program.size());
+    for (int i = 0; i < program.size(); i++) {
+        if (not cfg.reachable(i)) {
+            continue;
+        }
+        if (program[i].command == eCommands::Label &&
+            (not referenced.contains(program[i].param) || cfg.label_index(program[i].param) != i)) {
+            continue;
+        }
+        result.push_back(std::move(program[i]));
+    }
+    program = std::move(result);
+}
+
+bool Optimizer::remove_dead_stores(std::vector<Statement> &program) {
+    ControlFlowGraph cfg(program);
+    auto &blocks = cfg.blocks();
+    std::vector<int> live_in(blocks.size(), 0);
+    auto live_out = [&](int id) {
+        int live = 0;
+        for (auto &edge: blocks[id].successors) {
+            live |= live_in[edge.to];
+        }
+        return live;
+    };
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int id = static_cast<int>(blocks.size()) - 1; id >= 0; id--) {
+            int live = live_out(id);
+            for (int i = blocks[id].end - 1; i >= blocks[id].begin; i--) {
+                live = live_before(program[i], live, cfg);
+            }
+            if (live != live_in[id]) {
+                live_in[id] = live;
+                changed = true;
+            }
+        }
+    }
+
+    bool removed = false;
+    for (int id = 0; id < blocks.size(); id++) {
+        int live = live_out(id);
+        for (int i = blocks[id].end - 1; i >= blocks[id].begin; i--) {
+            auto &statement = program[i];
+            if (statement.command == eCommands::PopR && not(live & register_bit(statement.param))) {
+                statement = {eCommands::Pop, "", statement.line};
+                removed = true;
+            }
+            live = live_before(statement, live, cfg);
+        }
+    }
+
+    std::vector<bool> dead(program.size(), false);
+    int previous = -1;
+    for (int i = 0; i < program.size(); i++) {
+        auto command = program[i].command;
+        if (command == eCommands::Blank) {
+            continue;
+        }
+        if (command == eCommands::Pop && previous != -1 && not dead[previous] && is_push(program[previous].command)) {
+            dead[previous] = dead[i] = true;
+            removed = true;
+        }
+        previous = i;
+    }
+    if (removed) {
+        std::vector<Statement> result;
+        result.reserve(program.size());
+        for (int i = 0; i < program.size(); i++) {
+            if (not dead[i]) {
+                result.push_back(std::move(program[i]));
+            }
+        }
+        program = std::move(result);
+    }
+    return removed;
+}
+
+void Optimizer::replace_tail_calls(std::vector<Statement> &program) {
+    for (int i = 0; i < program.size(); i++) {
+        if (program[i].command != eCommands::Call) {
+            continue;
+        }
+        int next = i + 1;
+        while (next < program.size() &&
+               (program[next].command == eCommands::Blank || program[next].command == eCommands::Label)) {
+            next++;
+        }
+        if (next < program.size() && program[next].command == eCommands::Ret) {
+            program[i].command = eCommands::Jump;
+        }
+    }
+}
+
+void Optimizer::inline_calls(std::vector<Statement> &program, int budget) {
+    ControlFlowGraph cfg(program);
+    auto &blocks = cfg.blocks();
+
+    std::set<std::string> names;
+    for (auto &statement: program) {
+        if (statement.command == eCommands::Label) {
+            names.insert(statement.param);
+        }
+    }
+
+    std::map<std::string, std::pair<int, int>> bodies;
+    auto body_of = [&](const std::string &name) -> std::pair<int, int> {
+        if (bodies.contains(name)) {
+            return bodies[name];
+        }
+        auto &body = bodies[name] = {-1, -1};
+        int first = cfg.block_of(cfg.label_index(name));
+        std::set<int> region{first};
+        std::vector<int> queue{first};
+        while (not queue.empty()) {
+            int id = queue.back();
+            queue.pop_back();
+            for (int i = blocks[id].begin; i < blocks[id].end; i++) {
+                auto command = program[i].command;
+                if (command == eCommands::Call || command == eCommands::Spawn || command == eCommands::Begin ||
+                    command == eCommands::End ||
+                    (ControlFlowGraph::is_jump(command) && cfg.label_index(program[i].param) == -1)) {
+                    return body;
+                }
+            }
+            // A body that runs off the end of the program would continue into the caller once inlined
+            if (blocks[id].end == program.size()) {
+                int last = blocks[id].end - 1;
+                while (last > blocks[id].begin && program[last].command == eCommands::Blank) {
+                    last--;
+                }
+                if (program[last].command != eCommands::Ret && program[last].command != eCommands::Jump) {
+                    return body;
+                }
+            }
+            for (auto &edge: blocks[id].successors) {
+                if (region.insert(edge.to).second) {
+                    queue.push_back(edge.to);
+                }
+            }
+        }
+        if (*region.begin() != first || *region.rbegin() - first + 1 != region.size()) {
+            return body;
+        }
+        int begin = blocks[first].begin;
+        int end = blocks[*region.rbegin()].end;
+        int size = 0;
+        for (int i = begin; i < end; i++) {
+            auto command = program[i].command;
+            size += command != eCommands::Blank && command != eCommands::Label;
+        }
+        if (size > budget) {
+            return body;
+        }
+        for (int i = 0; i < program.size(); i++) {
+            if ((i < begin || end <= i) && ControlFlowGraph::is_jump(program[i].command)) {
+                int target = cfg.label_index(program[i].param);
+                if (begin < target && target < end) {
+                    return body;
+                }
+            }
+        }
+        return body = {begin, end};
+    };
+    auto fresh = [&](const std::string &name) {
+        for (int n = 0;; n++) {
+            auto candidate = name + "inl" + std::to_string(n);
+            if (names.insert(candidate).second) {
+                return candidate;
+            }
+        }
+    };
+
+    std::vector<Statement> result;
+    result.reserve(program.size());
+    for (int i = 0; i < program.size(); i++) {
+        auto &statement = program[i];
+        if (statement.command != eCommands::Call || not cfg.reachable(i) ||
+            cfg.label_index(statement.param) == -1) {
+            result.push_back(statement);
+            continue;
+        }
+        auto [begin, end] = body_of(statement.param);
+        if (begin == -1) {
+            result.push_back(statement);
+            continue;
+        }
+
+        std::map<std::string, std::string> renamed;
+        for (int j = begin; j < end; j++) {
+            if (program[j].command == eCommands::Label && cfg.label_index(program[j].param) == j) {
+                renamed[program[j].param] = fresh(program[j].param);
+            }
+        }
+        int last = end - 1;
+        while (program[last].command == eCommands::Blank) {
+            last--;
+        }
+        auto resume = fresh(statement.param);
+        bool jumps_to_exit = false;
+        for (int j = begin; j < end; j++) {
+            auto copy = program[j];
+            if (copy.command == eCommands::Blank || (j == last && copy.command == eCommands::Ret) ||
+                (copy.command == eCommands::Label && not renamed.contains(copy.param))) {
+                continue;
+            }
+            if (copy.command == eCommands::Ret) {
+                copy = {eCommands::Jump, resume, copy.line};
+                jumps_to_exit = true;
+            } else if (copy.command == eCommands::Label || ControlFlowGraph::is_jump(copy.command)) {
+                if (renamed.contains(copy.param)) {
+                    copy.param = renamed[copy.param];
+                }
+            }
+            result.push_back(std::move(copy));
+        }
+        if (jumps_to_exit) {
+            result.push_back({eCommands::Label, resume, statement.line});
+        }
+    }
+    program = std::move(result);
+}
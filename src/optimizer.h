@@ -0,0 +1,23 @@
+#pragma once
+
+#include <vector>
+#include "cfg.h"
+
+class Optimizer {
+public:
+    explicit Optimizer(int level, int inline_budget = 16) : level_(level), inline_budget_(inline_budget) {}
+
+    void run(std::vector<Statement> &) const;
+
+    static void remove_unreachable(std::vector<Statement> &);
+
+    static bool remove_dead_stores(std::vector<Statement> &);
+
+    static void replace_tail_calls(std::vector<Statement> &);
+
+    static void inline_calls(std::vector<Statement> &, int);
+
+private:
+    int level_;
+    int inline_budget_;
+};
@@ -1,6 +1,9 @@
 #include <string>
 #include <sstream>
 #include <utility>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
 #include "parser.h"
 #include "commands.h"
 #include "exc.h"
@@ -16,34 +19,40 @@ void Parser::parse(const std::string &file_name) {
     std::string param;
     int line_number = 1;
     while (not file.eof()) {
-        command.clear();
-        param.clear();
         std::getline(file, line);
-        std::stringstream line_stream(line);
-        line_stream >> command;
-        if (command.empty() || command.starts_with('/')) {
-            command = "BLANK";
+        int column = split(line, line_number++, command, param);
+        program_.emplace_back(command, param);
+        columns_.push_back(column);
+    }
+}
+
+int Parser::split(const std::string &line, int line_number, std::string &command, std::string &param) {
+    command.clear();
+    param.clear();
+    std::stringstream line_stream(line);
+    line_stream >> command;
+    auto column = line.find_first_not_of(" \t\r");
+    if (command.empty() || command.starts_with('/')) {
+        command = "BLANK";
+        line_stream.str("");
+    } else if (command.ends_with(':')) {
+        command.pop_back();
+        param = std::move(command);
+        command = "LABEL";
+    } else {
+        std::transform(command.begin(), command.end(), command.begin(), ::toupper);
+        line_stream >> param;
+        if (param.starts_with('/')) {
+            param = "";
             line_stream.str("");
-        } else if (command.ends_with(':')) {
-            command.pop_back();
-            param = std::move(command);
-            command = "LABEL";
-        } else {
-            std::transform(command.begin(), command.end(), command.begin(), ::toupper);
-            line_stream >> param;
-            if (param.starts_with('/')) {
-                param = "";
-                line_stream.str("");
-            }
-        }
-        std::string tmp;
-        line_stream >> tmp;
-        if (not tmp.empty() and not tmp.starts_with('/')) {
-            throw InvalidArgumentException("Too much arguments", line_number);
         }
-        line_number++;
-        program_.emplace_back(command, param);
     }
+    std::string tmp;
+    line_stream >> tmp;
+    if (not tmp.empty() and not tmp.starts_with('/')) {
+        throw InvalidArgumentException("Too much arguments", line_number);
+    }
+    return command == "BLANK" || column == std::string::npos ? 0 : static_cast<int>(column) + 1;
 }
 
 void Parser::parse_binary(const std::string &file_name) {
@@ -52,6 +61,58 @@ void Parser::parse_binary(const std::string &file_name) {
         throw std::runtime_error("File is closed");
     }
     clear();
+    std::string magic(binary_magic.size(), '\0');
+    file.read(magic.data(), static_cast<std::streamsize>(magic.size()));
+    bool compressed = magic == compressed_magic;
+    if (magic != binary_magic && not compressed) {
+        file.clear();
+        file.seekg(0);
+        parse_code(file);
+        return;
+    }
+    std::string code;
+    std::string dictionary;
+    while (file.peek() != EOF) {
+        auto section = static_cast<eSection>(file.get());
+        uint32_t size = 0;
+        file.read(reinterpret_cast<char *>(&size), sizeof(size));
+        std::string payload(size, '\0');
+        file.read(payload.data(), size);
+        if (not file) {
+            throw std::runtime_error("Binary file is truncated");
+        }
+        if (section == eSection::Code && compressed) {
+            code = std::move(payload);
+        } else if (section == eSection::Code) {
+            std::istringstream stream(payload);
+            parse_code(stream);
+        } else if (section == eSection::Dictionary) {
+            dictionary = std::move(payload);
+        } else if (section == eSection::State) {
+            parse_state(payload);
+        } else if (section == eSection::Hints) {
+            parse_hints(payload);
+        } else if (section == eSection::Pure) {
+            parse_pure(payload);
+        } else if (section == eSection::Symbols) {
+            parse_symbols(payload);
+        } else if (section == eSection::Exports) {
+            exports_ = parse_names(payload);
+            module_ = true;
+        } else if (section == eSection::Imports) {
+            imports_ = parse_names(payload);
+        } else if (section == eSection::Debug && compressed) {
+            debug_ = Codec::decompress_debug(payload);
+        } else if (section == eSection::Debug) {
+            parse_debug(payload);
+        }
+    }
+    if (compressed) {
+        Codec::decompress(dictionary, code, symbols_, program_);
+    }
+}
+
+void Parser::parse_code(std::istream &file) {
     char param[100]{};
     uint8_t command = file.get();
     while (not file.eof()) {
@@ -61,6 +122,84 @@ void Parser::parse_binary(const std::string &file_name) {
     }
 }
 
+void Parser::parse_state(const std::string &payload) {
+    std::istringstream stream(payload);
+    auto get = [&stream]() {
+        int32_t value = 0;
+        stream.read(reinterpret_cast<char *>(&value), sizeof(value));
+        if (not stream) {
+            throw std::runtime_error("Binary file is truncated");
+        }
+        return value;
+    };
+    auto get_values = [&get](std::vector<int> &values) {
+        values.resize(get());
+        for (auto &value: values) {
+            value = get();
+        }
+    };
+    ProgramState state;
+    state.entry = get();
+    get_values(state.registers);
+    get_values(state.data);
+    get_values(state.call);
+    get_values(state.output);
+    state_ = std::move(state);
+}
+
+void Parser::parse_hints(const std::string &payload) {
+    // Binaries built before linear memory carry only the two stack bounds
+    if (payload.size() != sizeof(StackHints) && payload.size() != offsetof(StackHints, memory)) {
+        throw std::runtime_error("Binary file is truncated");
+    }
+    std::memcpy(&hints_, payload.data(), payload.size());
+}
+
+void Parser::parse_pure(const std::string &payload) {
+    if (payload.size() % sizeof(PureSubroutine) != 0) {
+        throw std::runtime_error("Binary file is truncated");
+    }
+    pure_.resize(payload.size() / sizeof(PureSubroutine));
+    std::memcpy(pure_.data(), payload.data(), payload.size());
+}
+
+void Parser::parse_symbols(const std::string &payload) {
+    stripped_ = true;
+    size_t offset = 0;
+    while (offset < payload.size()) {
+        int32_t pc = 0;
+        auto end = payload.find('\0', offset + sizeof(pc));
+        if (end == std::string::npos) {
+            throw std::runtime_error("Binary file is truncated");
+        }
+        std::memcpy(&pc, payload.data() + offset, sizeof(pc));
+        symbols_.emplace_back(payload.substr(offset + sizeof(pc), end - offset - sizeof(pc)), pc);
+        offset = end + 1;
+    }
+}
+
+void Parser::parse_debug(const std::string &payload) {
+    if (payload.size() % sizeof(DebugLine) != 0) {
+        throw std::runtime_error("Binary file is truncated");
+    }
+    debug_.resize(payload.size() / sizeof(DebugLine));
+    std::memcpy(debug_.data(), payload.data(), payload.size());
+}
+
+std::vector<std::string> Parser::parse_names(const std::string &payload) {
+    std::vector<std::string> names;
+    size_t offset = 0;
+    while (offset < payload.size()) {
+        auto end = payload.find('\0', offset);
+        if (end == std::string::npos) {
+            throw std::runtime_error("Binary file is truncated");
+        }
+        names.push_back(payload.substr(offset, end - offset));
+        offset = end + 1;
+    }
+    return names;
+}
+
 std::vector<std::tuple<BaseCommand &, std::string>> Parser::get_program() {
     std::vector<std::tuple<BaseCommand &, std::string>> program{};
     program.reserve(program_.size());
@@ -85,6 +224,28 @@ std::vector<std::tuple<eCommands, std::string>> Parser::get_raw_program() {
     return raw_program;
 }
 
+std::vector<Statement> Parser::get_statements() {
+    std::vector<Statement> statements;
+    auto program = get_program();
+    statements.reserve(program.size());
+    int line = 1;
+    for (auto [comma, param]: program) {
+        int column = line - 1 < columns_.size() ? columns_[line - 1] : 0;
+        statements.push_back({comma.name(), param, line++, column});
+    }
+    return statements;
+}
+
 void Parser::clear() {
     program_.clear();
+    state_.reset();
+    hints_ = {};
+    pure_.clear();
+    columns_.clear();
+    symbols_.clear();
+    debug_.clear();
+    exports_.clear();
+    imports_.clear();
+    stripped_ = false;
+    module_ = false;
 }
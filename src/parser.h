@@ -3,7 +3,31 @@
 #include <string>
 #include <fstream>
 #include <map>
+#include <optional>
+#include "codec.h"
 #include "commands.h"
+#include "memo.h"
+
+struct Statement {
+    eCommands command;
+    std::string param;
+    int line;
+    int column = 0;
+};
+
+struct ProgramState {
+    int entry = -1;
+    std::vector<int> registers;
+    std::vector<int> data;
+    std::vector<int> call;
+    std::vector<int> output;
+};
+
+enum class eSection : uint8_t {
+    Code = 1, State, Hints, Pure, Symbols, Debug, Dictionary, Exports, Imports
+};
+
+static const std::string binary_magic = std::string("EMU\x01", 4);
 
 class Parser {
 public:
@@ -13,12 +37,58 @@ public:
 
     void parse_binary(const std::string &);
 
+    static int split(const std::string &, int, std::string &, std::string &);
+
     std::vector<std::tuple<BaseCommand &, std::string>> get_program();
 
     std::vector<std::tuple<eCommands, std::string>> get_raw_program();
 
+    std::vector<Statement> get_statements();
+
+    [[nodiscard]] const std::optional<ProgramState> &get_state() const { return state_; }
+
+    [[nodiscard]] const StackHints &get_hints() const { return hints_; }
+
+    [[nodiscard]] const std::vector<PureSubroutine> &get_pure() const { return pure_; }
+
+    [[nodiscard]] const std::vector<std::pair<std::string, int>> &get_symbols() const { return symbols_; }
+
+    [[nodiscard]] const std::vector<DebugLine> &get_debug() const { return debug_; }
+
+    [[nodiscard]] const std::vector<std::string> &get_exports() const { return exports_; }
+
+    [[nodiscard]] const std::vector<std::string> &get_imports() const { return imports_; }
+
+    [[nodiscard]] bool stripped() const { return stripped_; }
+
+    [[nodiscard]] bool module() const { return module_; }
+
     void clear();
 
 private:
+    void parse_code(std::istream &);
+
+    void parse_state(const std::string &);
+
+    void parse_hints(const std::string &);
+
+    void parse_pure(const std::string &);
+
+    void parse_symbols(const std::string &);
+
+    void parse_debug(const std::string &);
+
+    static std::vector<std::string> parse_names(const std::string &);
+
     std::vector<std::tuple<std::string, std::string>> program_;
+    std::optional<ProgramState> state_;
+    StackHints hints_;
+    std::vector<PureSubroutine> pure_;
+    std::vector<int> columns_;
+    std::vector<std::pair<std::string, int>> symbols_;
+    std::vector<DebugLine> debug_;
+    std::vector<std::string> exports_;
+    std::vector<std::string> imports_;
+    bool stripped_ = false;
+    bool module_ = false;
 };
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include "perf.h"
+
+#ifdef __linux__
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#endif
+
+namespace {
+    const std::array<std::string, std::tuple_size_v<PerfValues>> event_name = {
+            "cycles", "instructions", "branch-misses", "cache-misses"
+    };
+}
+
+#ifdef __linux__
+
+PerfCounters::PerfCounters() {
+    const std::array<uint64_t, std::tuple_size_v<PerfValues>> configs = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_CACHE_MISSES
+    };
+    fds_.fill(-1);
+    for (size_t i = 0; i < configs.size(); i++) {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = configs[i];
+        attr.disabled = leader_ == -1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader_, 0));
+        if (fd == -1) {
+            if (error_.empty()) {
+                error_ = event_name[i] + ": " + std::strerror(errno);
+            }
+            continue;
+        }
+        fds_[i] = fd;
+        opened_[i] = true;
+        if (leader_ == -1) {
+            leader_ = fd;
+        }
+    }
+    if (available()) {
+        ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        calibrate();
+    }
+}
+
+PerfCounters::~PerfCounters() {
+    for (auto fd: fds_) {
+        if (fd != -1) {
+            close(fd);
+        }
+    }
+}
+
+PerfValues PerfCounters::read() const {
+    PerfValues values{};
+    if (not available()) {
+        return values;
+    }
+    std::array<uint64_t, std::tuple_size_v<PerfValues> + 1> buffer{};
+    if (::read(leader_, buffer.data(), sizeof(buffer)) <= 0) {
+        return values;
+    }
+    size_t next = 1;
+    for (size_t i = 0; i < values.size() && next <= buffer[0]; i++) {
+        if (opened_[i]) {
+            values[i] = buffer[next++];
+        }
+    }
+    return values;
+}
+
+#else
+
+PerfCounters::PerfCounters() : error_("perf_event_open is only available on Linux") {
+    fds_.fill(-1);
+}
+
+PerfCounters::~PerfCounters() = default;
+
+PerfValues PerfCounters::read() const {
+    return {};
+}
+
+#endif
+
+void PerfCounters::calibrate() {
+    overhead_.fill(UINT64_MAX);
+    for (int i = 0; i < 64; i++) {
+        auto before = read();
+        auto after = read();
+        for (size_t j = 0; j < overhead_.size(); j++) {
+            overhead_[j] = std::min(overhead_[j], after[j] - before[j]);
+        }
+    }
+}
+
+void PerfCounters::begin_phase() {
+    phase_start_ = read();
+}
+
+void PerfCounters::end_phase(const std::string &name) {
+    auto end = read();
+    PerfValues delta{};
+    for (size_t i = 0; i < delta.size(); i++) {
+        delta[i] = end[i] - phase_start_[i];
+    }
+    phases_.emplace_back(name, delta);
+}
+
+void PerfCounters::report(std::ostream &out) const {
+    if (not available()) {
+        out << "perf: hardware counters are unavailable (" << error_ << ")" << std::endl;
+        return;
+    }
+    auto print = [&](const PerfValues &values) {
+        for (size_t i = 0; i < values.size(); i++) {
+            if (opened_[i]) {
+                out << ' ' << event_name[i] << '=' << values[i];
+            }
+        }
+    };
+    for (auto &[name, values]: phases_) {
+        out << "perf: phase " << name << ':';
+        print(values);
+        out << std::endl;
+    }
+    for (size_t i = 0; i < opcode_count; i++) {
+        if (samples_[i] == 0) {
+            continue;
+        }
+        out << "perf: opcode " << command_name.at(static_cast<eCommands>(i)) << " (" << samples_[i] << " samples):";
+        PerfValues average{};
+        for (size_t j = 0; j < average.size(); j++) {
+            average[j] = opcodes_[i][j] / samples_[i];
+        }
+        print(average);
+        out << std::endl;
+    }
+}
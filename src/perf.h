@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "commands.h"
+
+enum class ePerfEvent : uint8_t {
+    Cycles = 0, Instructions, BranchMisses, CacheMisses
+};
+
+using PerfValues = std::array<uint64_t, static_cast<size_t>(ePerfEvent::CacheMisses) + 1>;
+
+class PerfCounters {
+public:
+    PerfCounters();
+
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters &) = delete;
+
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    [[nodiscard]] bool available() const { return leader_ != -1; }
+
+    [[nodiscard]] const std::string &error() const { return error_; }
+
+    PerfValues read() const;
+
+    void begin_phase();
+
+    void end_phase(const std::string &);
+
+    void attribute(eCommands command, const PerfValues &before, const PerfValues &after) {
+        auto &total = opcodes_[static_cast<size_t>(command)];
+        for (size_t i = 0; i < total.size(); i++) {
+            uint64_t delta = after[i] - before[i];
+            total[i] += delta > overhead_[i] ? delta - overhead_[i] : 0;
+        }
+        samples_[static_cast<size_t>(command)]++;
+    }
+
+    void report(std::ostream &) const;
+
+private:
+    static constexpr size_t opcode_count = command_count;
+
+    void calibrate();
+
+    int leader_ = -1;
+    std::array<int, std::tuple_size_v<PerfValues>> fds_{};
+    std::array<bool, std::tuple_size_v<PerfValues>> opened_{};
+    std::string error_;
+    PerfValues overhead_{};
+    PerfValues phase_start_{};
+    std::vector<std::pair<std::string, PerfValues>> phases_;
+    std::array<PerfValues, opcode_count> opcodes_{};
+    std::array<uint64_t, opcode_count> samples_{};
+};
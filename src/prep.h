@@ -1,6 +1,34 @@
 #pragma once
 
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include "assembler.h"
 #include "parser.h"
+#include "program.h"
+#include "metrics.h"
+#include "optimizer.h"
+#include "evaluator.h"
+#include "layout.h"
+#include "linker.h"
+#include "translator.h"
+
+struct BuildOptions {
+    int opt_level = 1;
+    int inline_budget = 16;
+    int eval_budget = 100000;
+    bool dump_cfg = false;
+    bool strip = false;
+    bool stream = false;
+    bool compress = false;
+    bool module = false;
+    bool emit_c = false;
+    bool native = false;
+    std::string native_file;
+    std::vector<std::string> exports;
+    std::string profile_file;
+};
 
 class Preprocessor {
 public:
@@ -10,7 +38,28 @@ public:
         return parser_.get_program();
     }
 
-    void build(const std::string &file_name, const std::string &output_file_name) {
+    [[nodiscard]] const std::optional<ProgramState> &get_state() const {
+        return parser_.get_state();
+    }
+
+    [[nodiscard]] const StackHints &get_hints() const {
+        return hints_;
+    }
+
+    [[nodiscard]] const std::vector<PureSubroutine> &get_pure() const {
+        return parser_.get_pure();
+    }
+
+    void build(const std::string &file_name, const std::string &output_file_name, const BuildOptions &options = {}) {
+        if (options.stream) {
+            assemble(file_name, output_file_name, options);
+            return;
+        }
+        if (options.native && std::filesystem::weakly_canonical(executable_of(output_file_name, options)) ==
+                              std::filesystem::weakly_canonical(file_name)) {
+            std::cerr << "Native executable would overwrite the source file \"" + file_name + "\"" << std::endl;
+            exit(1);
+        }
         std::vector<std::tuple<BaseCommand &, std::string>> program;
         parser_.parse(file_name);
         program = parser_.get_program();
@@ -29,40 +78,325 @@ public:
             line++;
         }
         clear();
-        save(output_file_name);
+
+        auto statements = parser_.get_statements();
+        if (options.module) {
+            for (auto &name: options.exports) {
+                if (std::none_of(statements.begin(), statements.end(), [&name](const Statement &statement) {
+                    return statement.command == eCommands::Label && statement.param == name;
+                })) {
+                    std::cerr << "Exported label \"" << name << "\" is not defined" << std::endl;
+                    exit(1);
+                }
+            }
+            save(output_file_name, statements, {}, {}, std::nullopt, options);
+            return;
+        }
+        emit(output_file_name, statements, options);
+    }
+
+    void link(const std::vector<std::string> &modules, const std::string &output_file_name,
+              const BuildOptions &options = {}) {
+        std::vector<Statement> statements;
+        try {
+            statements = Linker().run(modules);
+        } catch (std::runtime_error &e) {
+            std::cerr << "Link error: " << e.what() << std::endl;
+            exit(1);
+        }
+        emit(output_file_name, statements, options);
     }
 
-    void load(const std::string &file_name) {
+    void load(const std::string &file_name, Metrics *metrics = nullptr) {
+        auto start = Metrics::clock::now();
         parser_.parse_binary(file_name);
+        auto parsed = Metrics::clock::now();
         auto program = parser_.get_program();
+        for (auto &[name, pc]: parser_.get_symbols()) {
+            LabelType::get(name).line() = pc;
+        }
         int line = 0;
         for (auto [command, param]: program) {
             command.configure(param, line++);
         }
+        // Stream builds carry no memory size in the header, only the MEMORY command in the code
+        hints_ = parser_.get_hints();
+        hints_.memory = std::max(hints_.memory, Memory::instance().get_size());
+        decoded_.clear();
+        decoded_.reserve(program.size());
+        for (auto [command, param]: program) {
+            decoded_.push_back({command.name(), command.encode(param)});
+        }
+        if (metrics) {
+            metrics->phases[static_cast<size_t>(ePhase::Parse)] += parsed - start;
+            metrics->phases[static_cast<size_t>(ePhase::Configure)] += Metrics::clock::now() - parsed;
+        }
+    }
+
+    [[nodiscard]] DebugLine debug_line(int pc) const {
+        auto &debug = parser_.get_debug();
+        if (0 <= pc && pc < debug.size()) {
+            return debug[pc];
+        }
+        if (0 <= pc && not parser_.stripped()) {
+            return {pc + 1, 0, -1};
+        }
+        return {};
+    }
+
+    [[nodiscard]] std::string label_name(int index) const {
+        auto &symbols = parser_.get_symbols();
+        return 0 <= index && index < symbols.size() ? symbols[index].first : "";
+    }
+
+    [[nodiscard]] std::string label_at(int pc) const {
+        for (auto &[name, target]: parser_.get_symbols()) {
+            if (target == pc) {
+                return name;
+            }
+        }
+        return "";
+    }
+
+    [[nodiscard]] const Program &get_decoded() const {
+        return decoded_;
+    }
+
+    Program &get_decoded() {
+        return decoded_;
     }
 
     static void clear() {
         for (auto [name, comma]: command_by_name) {
             comma.clear();
         }
-        RegisterType::clear_all();
         LabelType::clear_all();
     }
 
 private:
 
-    void save(std::string file_name) {
+    static void emit(const std::string &output_file_name, std::vector<Statement> &statements,
+                     const BuildOptions &options) {
+        int32_t memory = 0;
+        for (auto &statement: statements) {
+            if (statement.command == eCommands::Memory) {
+                memory = std::max(memory, std::stoi(statement.param));
+            }
+        }
+        Optimizer(options.opt_level, options.inline_budget).run(statements);
+        if (not options.profile_file.empty()) {
+            std::ifstream profile(options.profile_file);
+            if (not profile.is_open()) {
+                std::cerr << "Can not open file \"" + options.profile_file + "\"" << std::endl;
+                exit(1);
+            }
+            Layout(Layout::read(profile)).run(statements);
+        }
+        std::optional<ProgramState> state;
+        if (options.opt_level >= 2 && options.eval_budget > 0) {
+            state = PartialEvaluator(options.eval_budget).run(statements);
+            clear();
+        }
+        ControlFlowGraph cfg(statements);
+        if (options.dump_cfg) {
+            cfg.dump(std::cout);
+        }
+        auto hints = cfg.stack_bounds();
+        if (state && not state->call.empty()) {
+            hints = {};
+        } else if (state && hints.data != -1) {
+            hints.data += static_cast<int32_t>(state->data.size());
+        }
+        hints.memory = memory;
+        if (options.emit_c) {
+            translate(output_file_name, statements, hints, state, options);
+            return;
+        }
+        save(output_file_name, statements, hints, cfg.pure_subroutines(), state, options);
+    }
+
+    static void translate(const std::string &output_file_name, const std::vector<Statement> &statements,
+                          const StackHints &hints, const std::optional<ProgramState> &state,
+                          const BuildOptions &options) {
+        auto file_name = output_file_name + ".c";
+        std::ofstream file(file_name);
+        if (not file.is_open()) {
+            std::cerr << "Can not create file \"" + file_name + "\"" << std::endl;
+            exit(1);
+        }
+        try {
+            Translator(hints).run(statements, state, file);
+        } catch (std::runtime_error &e) {
+            std::cerr << e.what() << std::endl;
+            exit(1);
+        }
+        file.close();
+        if (options.native) {
+            auto *compiler = std::getenv("CC");
+            auto command = std::string(compiler ? compiler : "cc") + " -O2 -o \"" +
+                           executable_of(output_file_name, options) + "\" \"" + file_name + "\"";
+            if (std::system(command.c_str()) != 0) {
+                std::cerr << "C compiler failed: " << command << std::endl;
+                exit(1);
+            }
+        }
+    }
+
+    static std::string executable_of(const std::string &output_file_name, const BuildOptions &options) {
+        return options.native_file.empty() ? output_file_name : options.native_file;
+    }
+
+    static void assemble(const std::string &file_name, const std::string &output_file_name,
+                         const BuildOptions &options) {
+        try {
+            Assembler(not options.strip).run(file_name, output_file_name);
+        } catch (InvalidArgumentException &e) {
+            std::cerr << "Error in line " << e.line() << ": " << e.what() << std::endl;
+            exit(1);
+        } catch (UniqueException &e) {
+            std::cerr << "Error in line " << e.line() << ": " << e.what() << std::endl;
+            exit(1);
+        }
+        clear();
+    }
+
+    static void save(std::string file_name, const std::vector<Statement> &program, const StackHints &hints,
+                     std::vector<PureSubroutine> pure, std::optional<ProgramState> state,
+                     const BuildOptions &options) {
         file_name += ".emu";
-        auto program = parser_.get_raw_program();
         std::ofstream file(file_name, std::ios::binary | std::ios::out);
         if (not file.is_open()) {
             std::cerr << "Can not create file \"" + file_name + "\"" << std::endl;
             exit(1);
         }
-        for (auto [comma_id, param]: program) {
-            file << static_cast<uint8_t>(comma_id) << param << '\0';
+        std::vector<int> pc_of(program.size() + 1, 0);
+        for (int i = 0; i < program.size(); i++) {
+            pc_of[i + 1] = pc_of[i] + not is_pseudo(program[i].command);
+        }
+        Codec::Code code;
+        Codec::Symbols symbols;
+        std::vector<DebugLine> lines;
+        for (int i = 0; i < program.size(); i++) {
+            auto &statement = program[i];
+            if (statement.command == eCommands::Label) {
+                symbols.emplace_back(statement.param, pc_of[i]);
+            } else if (statement.command != eCommands::Blank) {
+                code.emplace_back(statement.command, statement.param);
+                lines.push_back({statement.line, statement.column, static_cast<int32_t>(symbols.size()) - 1});
+            }
+        }
+        for (auto &subroutine: pure) {
+            subroutine.entry = pc_of[subroutine.entry];
+        }
+        if (state) {
+            state->entry = pc_of[state->entry];
+            for (auto &address: state->call) {
+                address = pc_of[address];
+            }
+        }
+
+        if (options.compress) {
+            auto [dictionary, compressed] = Codec::compress(code, symbols);
+            file << compressed_magic;
+            write_section(file, eSection::Symbols, encode_symbols(symbols));
+            write_section(file, eSection::Dictionary, dictionary);
+            write_section(file, eSection::Code, compressed);
+            if (not options.strip) {
+                write_section(file, eSection::Debug, Codec::compress_debug(lines));
+            }
+        } else {
+            std::string payload;
+            for (auto &[command, param]: code) {
+                payload.push_back(static_cast<char>(command));
+                payload.append(param).push_back('\0');
+            }
+            file << binary_magic;
+            write_section(file, eSection::Code, payload);
+            write_section(file, eSection::Symbols, encode_symbols(symbols));
+            if (not options.strip) {
+                write_section(file, eSection::Debug, std::string(reinterpret_cast<const char *>(lines.data()),
+                                                                 lines.size() * sizeof(DebugLine)));
+            }
+        }
+        if (options.module) {
+            std::set<std::string> defined;
+            std::set<std::string> referenced;
+            for (auto &statement: program) {
+                if (statement.command == eCommands::Label) {
+                    defined.insert(statement.param);
+                } else if (ControlFlowGraph::is_jump(statement.command)) {
+                    referenced.insert(statement.param);
+                }
+            }
+            std::vector<std::string> exports = options.exports;
+            if (exports.empty()) {
+                exports.assign(defined.begin(), defined.end());
+            }
+            std::vector<std::string> imports;
+            std::set_difference(referenced.begin(), referenced.end(), defined.begin(), defined.end(),
+                                std::back_inserter(imports));
+            write_section(file, eSection::Exports, encode_names(exports));
+            write_section(file, eSection::Imports, encode_names(imports));
+        }
+        write_section(file, eSection::Hints, std::string(reinterpret_cast<const char *>(&hints), sizeof(hints)));
+        if (not pure.empty()) {
+            write_section(file, eSection::Pure, std::string(reinterpret_cast<const char *>(pure.data()),
+                                                            pure.size() * sizeof(PureSubroutine)));
         }
+        if (state) {
+            write_section(file, eSection::State, encode_state(*state));
+        }
+    }
+
+    static bool is_pseudo(eCommands command) {
+        return command == eCommands::Blank || command == eCommands::Label;
+    }
+
+    static void write_section(std::ostream &file, eSection section, const std::string &payload) {
+        auto size = static_cast<uint32_t>(payload.size());
+        file << static_cast<uint8_t>(section);
+        file.write(reinterpret_cast<const char *>(&size), sizeof(size));
+        file << payload;
+    }
+
+    static std::string encode_names(const std::vector<std::string> &names) {
+        std::string payload;
+        for (auto &name: names) {
+            payload.append(name).push_back('\0');
+        }
+        return payload;
+    }
+
+    static std::string encode_symbols(const Codec::Symbols &symbols) {
+        std::string payload;
+        for (auto &[name, pc]: symbols) {
+            int32_t address = pc;
+            payload.append(reinterpret_cast<const char *>(&address), sizeof(address));
+            payload.append(name).push_back('\0');
+        }
+        return payload;
+    }
+
+    static std::string encode_state(const ProgramState &state) {
+        std::string payload;
+        auto put = [&payload](int32_t value) {
+            payload.append(reinterpret_cast<const char *>(&value), sizeof(value));
+        };
+        auto put_values = [&put](const std::vector<int> &values) {
+            put(static_cast<int32_t>(values.size()));
+            for (auto value: values) {
+                put(value);
+            }
+        };
+        put(state.entry);
+        put_values(state.registers);
+        put_values(state.data);
+        put_values(state.call);
+        put_values(state.output);
+        return payload;
     }
 
     Parser parser_;
+    StackHints hints_;
+    Program decoded_;
 };
\ No newline at end of file
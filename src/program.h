@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <new>
+#include <vector>
+#include "commands.h"
+
+template<class T, std::size_t Alignment = 64>
+class AlignedAllocator {
+public:
+    using value_type = T;
+
+    template<class U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+
+    template<class U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment> &) {}
+
+    T *allocate(std::size_t n) {
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T *ptr, std::size_t) {
+        ::operator delete(ptr, std::align_val_t(Alignment));
+    }
+
+    bool operator==(const AlignedAllocator &) const { return true; }
+
+    bool operator!=(const AlignedAllocator &) const { return false; }
+};
+
+struct alignas(8) Instruction {
+    eCommands command;
+    int32_t operand;
+};
+
+static_assert(sizeof(Instruction) == 8);
+
+class Program {
+public:
+    Program() = default;
+
+    const Instruction &operator[](int pc) const { return code_[pc]; }
+
+    void patch(int pc, Instruction instruction) { code_[pc] = instruction; }
+
+    [[nodiscard]] int size() const { return static_cast<int>(code_.size()); }
+
+    [[nodiscard]] const Instruction *data() const { return code_.data(); }
+
+    void reserve(std::size_t size) { code_.reserve(size); }
+
+    void push_back(Instruction instruction) { code_.push_back(instruction); }
+
+    void clear() { code_.clear(); }
+
+private:
+    std::vector<Instruction, AlignedAllocator<Instruction>> code_;
+};
@@ -0,0 +1,212 @@
+#include <algorithm>
+#include "fence.h"
+#include "program.h"
+#include "scheduler.h"
+
+namespace {
+    struct Current {
+        const Scheduler *owner = nullptr;
+        int index = -1;
+    };
+
+    thread_local Current current;
+}
+
+Scheduler::Scheduler(const Program &program, int workers, uint32_t cutoff) : program_(program), cutoff_(cutoff) {
+    for (int i = 0; i < workers; i++) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (int i = 0; i < workers; i++) {
+        workers_[i]->thread = std::thread(&Scheduler::work, this, i);
+    }
+}
+
+Scheduler::~Scheduler() {
+    {
+        std::lock_guard lock(idle_mutex_);
+        stop_ = true;
+    }
+    idle_.notify_all();
+    for (auto &worker: workers_) {
+        worker->thread.join();
+    }
+}
+
+int Scheduler::spawn(int target, uint32_t count, Context *parent) {
+    auto [handle, task] = acquire();
+    auto *child = task->context.get();
+    std::copy_n(parent->registers, RegisterType::available.size(), child->registers);
+    for (uint32_t i = parent->data.size() - count; i < parent->data.size(); i++) {
+        child->data.push(parent->data.at(i));
+    }
+    // RET from the entry frame resumes at -1, which ends the child like falling off the program
+    child->call.push(-2);
+    child->pc = target;
+    child->depth = parent->depth + 1;
+    child->journal = parent->journal;
+    child->node = parent->node;
+    // Tasks share the memory of the VM that spawned them, ordering their accesses is up to the program
+    child->memory = parent->memory;
+    child->memory_size = parent->memory_size;
+    spawned_.fetch_add(1, std::memory_order_relaxed);
+    if (workers_.empty() || child->depth > cutoff_) {
+        inlined_.fetch_add(1, std::memory_order_relaxed);
+        execute(*task);
+    } else {
+        push(task);
+    }
+    return handle;
+}
+
+int Scheduler::join(Context *context) {
+    int handle = context->data.top();
+    Task *task = nullptr;
+    {
+        std::lock_guard lock(slots_mutex_);
+        if (0 <= handle && handle < tasks_.size() && tasks_[handle].live) {
+            task = &tasks_[handle];
+            task->live = false;
+        }
+    }
+    if (task == nullptr) {
+        return trap(eTrap::BadTask);
+    }
+    context->data.pop();
+    int self = current.owner == this ? current.index : -1;
+    while (not task->done.load(std::memory_order_acquire)) {
+        if (auto *other = take(self)) {
+            execute(*other);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    auto &results = task->context->data;
+    int status = task->status;
+    if (status == 0 && context->data.capacity() - context->data.size() < results.size()) {
+        status = trap(eTrap::StackOverflow);
+    }
+    if (status == 0) {
+        for (uint32_t i = 0; i < results.size(); i++) {
+            context->data.push(results.at(i));
+        }
+    }
+    release(handle);
+    return status;
+}
+
+std::pair<int, Scheduler::Task *> Scheduler::acquire() {
+    std::lock_guard lock(slots_mutex_);
+    int handle;
+    if (free_.empty()) {
+        handle = static_cast<int>(tasks_.size());
+        tasks_.emplace_back();
+    } else {
+        handle = free_.back();
+        free_.pop_back();
+    }
+    auto &task = tasks_[handle];
+    if (task.context) {
+        task.context->data.clear();
+        task.context->call.clear();
+    } else {
+        task.context = Context::create();
+        task.context->scheduler = this;
+    }
+    task.status = 0;
+    task.live = true;
+    task.done.store(false, std::memory_order_relaxed);
+    return {handle, &task};
+}
+
+void Scheduler::release(int handle) {
+    std::lock_guard lock(slots_mutex_);
+    free_.push_back(handle);
+}
+
+void Scheduler::push(Task *task) {
+    int self = current.owner == this ? current.index : -1;
+    auto index = self != -1 ? self : next_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+    auto &worker = *workers_[index];
+    {
+        std::lock_guard lock(worker.mutex);
+        queued_.fetch_add(1);
+        worker.tasks.push_back(task);
+    }
+    if (sleepers_.load() > 0) {
+        std::lock_guard lock(idle_mutex_);
+        idle_.notify_one();
+    }
+}
+
+Scheduler::Task *Scheduler::take(int self) {
+    if (queued_.load(std::memory_order_relaxed) <= 0) {
+        return nullptr;
+    }
+    if (self != -1) {
+        auto &worker = *workers_[self];
+        std::lock_guard lock(worker.mutex);
+        if (not worker.tasks.empty()) {
+            auto *task = worker.tasks.back();
+            worker.tasks.pop_back();
+            queued_.fetch_sub(1);
+            return task;
+        }
+    }
+    for (size_t i = 0; i < workers_.size(); i++) {
+        auto victim = static_cast<int>((self + 1 + i) % workers_.size());
+        if (victim == self) {
+            continue;
+        }
+        auto &worker = *workers_[victim];
+        std::lock_guard lock(worker.mutex);
+        if (not worker.tasks.empty()) {
+            auto *task = worker.tasks.front();
+            worker.tasks.pop_front();
+            queued_.fetch_sub(1);
+            stolen_.fetch_add(1, std::memory_order_relaxed);
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+void Scheduler::execute(Task &task) {
+    auto *context = task.context.get();
+    int status = fenced(*context, [&] {
+        int line = context->pc;
+        while (-1 < line && line < program_.size()) {
+            auto [command, operand] = program_[line];
+            if constexpr (guarded_stacks) {
+                context->pc = line;
+            }
+            int next = command_by_id[static_cast<size_t>(command)]->execute(operand, line, context);
+            if (next < 0) {
+                context->pc = line;
+                return next == trap(eTrap::Halt) ? 0 : next;
+            }
+            line = next;
+        }
+        context->pc = line;
+        return 0;
+    });
+    context->flush();
+    task.status = status;
+    task.done.store(true, std::memory_order_release);
+}
+
+void Scheduler::work(int self) {
+    current = {this, self};
+    while (true) {
+        if (auto *task = take(self)) {
+            execute(*task);
+            continue;
+        }
+        std::unique_lock lock(idle_mutex_);
+        sleepers_.fetch_add(1);
+        idle_.wait(lock, [this] { return stop_ || queued_.load() > 0; });
+        sleepers_.fetch_sub(1);
+        if (stop_) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "context.h"
+
+class Program;
+
+class Scheduler {
+public:
+    static constexpr uint32_t default_cutoff = 8;
+
+    Scheduler(const Program &program, int workers, uint32_t cutoff = default_cutoff);
+
+    ~Scheduler();
+
+    Scheduler(const Scheduler &) = delete;
+
+    Scheduler &operator=(const Scheduler &) = delete;
+
+    int spawn(int target, uint32_t count, Context *parent);
+
+    int join(Context *context);
+
+    [[nodiscard]] uint64_t spawned() const { return spawned_.load(std::memory_order_relaxed); }
+
+    [[nodiscard]] uint64_t inlined() const { return inlined_.load(std::memory_order_relaxed); }
+
+    [[nodiscard]] uint64_t stolen() const { return stolen_.load(std::memory_order_relaxed); }
+
+private:
+    struct Task {
+        Context::Pointer context;
+        int status = 0;
+        bool live = false;
+        std::atomic<bool> done{false};
+    };
+
+    struct alignas(64) Worker {
+        std::mutex mutex;
+        std::deque<Task *> tasks;
+        std::thread thread;
+    };
+
+    std::pair<int, Task *> acquire();
+
+    void release(int handle);
+
+    void push(Task *task);
+
+    Task *take(int self);
+
+    void execute(Task &task);
+
+    void work(int self);
+
+    const Program &program_;
+    uint32_t cutoff_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    std::mutex slots_mutex_;
+    std::deque<Task> tasks_;
+    std::vector<int> free_;
+
+    std::atomic<int> queued_{0};
+    std::atomic<int> sleepers_{0};
+    std::atomic<uint32_t> next_{0};
+    std::mutex idle_mutex_;
+    std::condition_variable idle_;
+    bool stop_ = false;
+
+    std::atomic<uint64_t> spawned_{0};
+    std::atomic<uint64_t> inlined_{0};
+    std::atomic<uint64_t> stolen_{0};
+};
@@ -0,0 +1,261 @@
+#include <algorithm>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include "cfg.h"
+#include "translator.h"
+
+namespace {
+    const std::map<eCommands, std::string> condition{
+            {eCommands::JumpE,  "=="},
+            {eCommands::JumpNE, "!="},
+            {eCommands::JumpG,  ">"},
+            {eCommands::JumpGE, ">="},
+            {eCommands::JumpL,  "<"},
+            {eCommands::JumpLE, "<="}
+    };
+
+    template<class T>
+    std::string join(const std::vector<T> &values) {
+        std::string text;
+        for (auto &value: values) {
+            text += (text.empty() ? "" : ", ") + std::to_string(value);
+        }
+        return text;
+    }
+}
+
+Translator::Translator(const StackHints &hints) {
+    auto context = Context::create(hints);
+    data_capacity_ = context->data.capacity();
+    call_capacity_ = context->call.capacity();
+    memory_size_ = context->memory_size;
+}
+
+std::string Translator::quote(const std::string &text) {
+    std::string quoted = "\"";
+    for (char c: text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+void Translator::run(const std::vector<Statement> &program, const std::optional<ProgramState> &state,
+                     std::ostream &out) const {
+    std::map<std::string, int> labels;
+    std::vector<int> calls;
+    int entry = -1;
+    for (int i = 0; i < program.size(); i++) {
+        auto command = program[i].command;
+        if (command == eCommands::Spawn || command == eCommands::Join) {
+            throw std::runtime_error("SPAWN and JOIN can not be translated to C");
+        }
+        if (command == eCommands::Label) {
+            labels[program[i].param] = i;
+        } else if (command == eCommands::Call) {
+            calls.push_back(i);
+        } else if (command == eCommands::Begin && entry == -1) {
+            entry = i;
+        }
+    }
+    auto target_of = [&labels](const Statement &statement) {
+        auto it = labels.find(statement.param);
+        return it == labels.end() ? -1 : it->second;
+    };
+    if (state) {
+        entry = state->entry;
+        for (int call: state->call) {
+            calls.push_back(call);
+        }
+    }
+    std::set<int> targets{entry};
+    for (int call: calls) {
+        targets.insert(call + 1);
+    }
+    for (auto &statement: program) {
+        if (ControlFlowGraph::is_jump(statement.command)) {
+            targets.insert(target_of(statement));
+        }
+    }
+    std::sort(calls.begin(), calls.end());
+    calls.erase(std::unique(calls.begin(), calls.end()), calls.end());
+
+    auto registers = RegisterType::available;
+    out << "/* Translated from an emulator program by 'build --emit-c' */\n"
+           "#include <limits.h>\n"
+           "#include <stdio.h>\n"
+           "#include <string.h>\n\n"
+           "#define DATA_CAPACITY " << data_capacity_ << "\n"
+           "#define CALL_CAPACITY " << call_capacity_ << "\n"
+           "#define MEMORY_SIZE " << memory_size_ << "\n"
+           "#define TRAP(line, message) do { fflush(stdout); "
+           "fprintf(stderr, \"Error in line %d: %s\\n\", line, message); return 0; } while (0)\n"
+           "#define NEED(count, line) if (sp < (count)) TRAP(line, \"Stack is empty\")\n"
+           "#define ROOM(line) if (sp == DATA_CAPACITY) TRAP(line, \"Stack overflow\")\n"
+           "#define SPAN(address, count, line) if ((address) < 0 || (count) < 0 || "
+           "(address) > MEMORY_SIZE - (count)) TRAP(line, \"Memory access out of bounds\")\n\n";
+    bool data = state && not state->data.empty();
+    bool call = state && not state->call.empty();
+    out << "static int data[DATA_CAPACITY]" << (data ? " = {" + join(state->data) + "}" : "") << ";\n";
+    out << "static int calls[CALL_CAPACITY]" << (call ? " = {" + join(state->call) + "}" : "") << ";\n";
+    out << "static int memory[MEMORY_SIZE > 0 ? MEMORY_SIZE : 1];\n\n";
+    out << "int main(void) {\n";
+    for (int i = 0; i < registers.size(); i++) {
+        out << "    int " << registers[i] << " = " << (state ? state->registers[i] : 0) << ";\n";
+    }
+    out << "    int sp = " << (state ? state->data.size() : 0) << ", cp = " << (state ? state->call.size() : 0)
+        << ", value;\n";
+    if (state) {
+        for (int value: state->output) {
+            out << "    printf(\"%d\\n\", " << value << ");\n";
+        }
+    }
+    if (entry == -1) {
+        out << "    return 0;\n}\n";
+        return;
+    }
+    out << "    goto i" << entry << ";\n";
+
+    for (int i = 0; i < program.size(); i++) {
+        auto &statement = program[i];
+        int line = statement.line;
+        if (targets.contains(i)) {
+            out << "i" << i << ":\n";
+        }
+        if (statement.command == eCommands::Begin || statement.command == eCommands::Label ||
+            statement.command == eCommands::Blank) {
+            continue;
+        }
+        auto unresolved = "TRAP(" + std::to_string(line) + ", " +
+                          quote("Can not find label \"" + statement.param + "\" to jump") + ");";
+        int target = ControlFlowGraph::is_jump(statement.command) ? target_of(statement) : -1;
+        auto jump = target == -1 ? unresolved : "goto i" + std::to_string(target) + ";";
+        out << "    ";
+        switch (statement.command) {
+            case eCommands::Push:
+                out << "ROOM(" << line << "); data[sp++] = " << std::stoi(statement.param) << ";";
+                break;
+            case eCommands::Pop:
+                out << "NEED(1, " << line << "); sp--;";
+                break;
+            case eCommands::PushR:
+                out << "ROOM(" << line << "); data[sp++] = " << statement.param << ";";
+                break;
+            case eCommands::PopR:
+                out << "NEED(1, " << line << "); " << statement.param << " = data[--sp];";
+                break;
+            case eCommands::Add:
+                out << "NEED(2, " << line << "); sp--; "
+                       "data[sp - 1] = (int) ((unsigned) data[sp - 1] + (unsigned) data[sp]);";
+                break;
+            case eCommands::Sub:
+                out << "NEED(2, " << line << "); sp--; "
+                       "data[sp - 1] = (int) ((unsigned) data[sp - 1] - (unsigned) data[sp]);";
+                break;
+            case eCommands::Mul:
+                out << "NEED(2, " << line << "); sp--; "
+                       "data[sp - 1] = (int) ((unsigned) data[sp - 1] * (unsigned) data[sp]);";
+                break;
+            case eCommands::Div:
+                out << "NEED(2, " << line << ");\n"
+                    << "    if (data[sp - 1] == 0) TRAP(" << line << ", \"Division by zero\");\n"
+                    << "    if (data[sp - 1] == -1 && data[sp - 2] == INT_MIN) TRAP(" << line
+                    << ", \"Division overflow\");\n"
+                    << "    sp--; data[sp - 1] /= data[sp];";
+                break;
+            case eCommands::In:
+                out << "ROOM(" << line << "); fputs(\"Input number: \", stdout); fflush(stdout); "
+                       "if (scanf(\"%d\", &value) != 1) value = 0; data[sp++] = value;";
+                break;
+            case eCommands::Out:
+                out << "NEED(1, " << line << "); printf(\"%d\\n\", data[--sp]);";
+                break;
+            case eCommands::Send:
+                out << "NEED(1, " << line << "); TRAP(" << line << ", "
+                    << quote("Channel " + std::to_string(std::stoi(statement.param)) + " is not connected") << ");";
+                break;
+            case eCommands::Recv:
+                out << "ROOM(" << line << "); TRAP(" << line << ", "
+                    << quote("Channel " + std::to_string(std::stoi(statement.param)) + " is not connected") << ");";
+                break;
+            case eCommands::Load:
+                out << "NEED(1, " << line << "); SPAN(data[sp - 1], 1, " << line << "); "
+                       "data[sp - 1] = memory[data[sp - 1]];";
+                break;
+            case eCommands::Store:
+                out << "NEED(2, " << line << "); SPAN(data[sp - 1], 1, " << line << "); "
+                       "memory[data[sp - 1]] = data[sp - 2]; sp -= 2;";
+                break;
+            case eCommands::LoadR:
+                out << "ROOM(" << line << "); SPAN(" << statement.param << ", 1, " << line << "); "
+                       "data[sp++] = memory[" << statement.param << "];";
+                break;
+            case eCommands::StoreR:
+                out << "NEED(1, " << line << "); SPAN(" << statement.param << ", 1, " << line << "); "
+                       "memory[" << statement.param << "] = data[--sp];";
+                break;
+            case eCommands::MemCpy:
+                out << "NEED(3, " << line << "); SPAN(data[sp - 2], data[sp - 1], " << line << "); "
+                       "SPAN(data[sp - 3], data[sp - 1], " << line << ");\n"
+                    << "    memmove(memory + data[sp - 3], memory + data[sp - 2], "
+                       "(size_t) data[sp - 1] * sizeof(int)); sp -= 3;";
+                break;
+            case eCommands::MemSet:
+                out << "NEED(3, " << line << "); SPAN(data[sp - 3], data[sp - 1], " << line << ");\n"
+                    << "    for (value = 0; value < data[sp - 1]; value++) memory[data[sp - 3] + value] = data[sp - 2];"
+                       " sp -= 3;";
+                break;
+            case eCommands::MemSum:
+                out << "NEED(2, " << line << "); SPAN(data[sp - 2], data[sp - 1], " << line << ");\n"
+                    << "    { unsigned total = 0; for (value = 0; value < data[sp - 1]; value++) "
+                       "total += (unsigned) memory[data[sp - 2] + value]; sp--; data[sp - 1] = (int) total; }";
+                break;
+            case eCommands::Jump:
+                out << jump;
+                break;
+            case eCommands::JumpE:
+            case eCommands::JumpNE:
+            case eCommands::JumpG:
+            case eCommands::JumpGE:
+            case eCommands::JumpL:
+            case eCommands::JumpLE:
+                out << "NEED(2, " << line << "); if (data[sp - 1] " << condition.at(statement.command)
+                    << " data[sp - 2]) " << jump;
+                break;
+            case eCommands::Call:
+                if (target == -1) {
+                    out << unresolved;
+                } else {
+                    out << "if (cp == CALL_CAPACITY) TRAP(" << line << ", \"Stack overflow\"); calls[cp++] = " << i
+                        << "; " << jump;
+                }
+                break;
+            case eCommands::Ret:
+                out << "if (cp == 0) TRAP(" << line << ", \"Call stack is empty\"); goto ret;";
+                break;
+            case eCommands::End:
+                out << "return 0;";
+                break;
+            default:
+                break;
+        }
+        out << "\n";
+    }
+    if (targets.contains(static_cast<int>(program.size()))) {
+        out << "i" << program.size() << ":\n";
+    }
+    out << "    return 0;\n";
+    if (std::any_of(program.begin(), program.end(), [](const Statement &statement) {
+        return statement.command == eCommands::Ret;
+    })) {
+        out << "ret:\n    switch (calls[--cp]) {\n";
+        for (int call: calls) {
+            out << "        case " << call << ": goto i" << call + 1 << ";\n";
+        }
+        out << "    }\n    return 0;\n";
+    }
+    out << "}\n";
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <optional>
+#include <ostream>
+#include <vector>
+#include "parser.h"
+
+class Translator {
+public:
+    explicit Translator(const StackHints &hints = {});
+
+    void run(const std::vector<Statement> &, const std::optional<ProgramState> &, std::ostream &) const;
+
+private:
+    static std::string quote(const std::string &);
+
+    uint32_t data_capacity_;
+    uint32_t call_capacity_;
+    uint32_t memory_size_;
+};
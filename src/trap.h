@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "data.h"
+
+enum class eTrap : uint8_t {
+    Ok = 0, Halt, Breakpoint, StackUnderflow, CallStackUnderflow, UnresolvedLabel, DivisionByZero, DivisionOverflow,
+    StackOverflow, Blocked, Disconnected, Deadlock, BadTask, BadAddress
+};
+
+constexpr int trap(eTrap kind) {
+    return -static_cast<int>(kind);
+}
+
+struct Trap {
+    eTrap kind = eTrap::Ok;
+    int pc = -1;
+    int line = -1;
+    uint32_t data_depth = 0;
+    uint32_t call_depth = 0;
+    int32_t operand = 0;
+
+    [[nodiscard]] bool fault() const {
+        return kind != eTrap::Ok && kind != eTrap::Halt && kind != eTrap::Breakpoint && kind != eTrap::Blocked;
+    }
+
+    [[nodiscard]] std::string message() const {
+        switch (kind) {
+            case eTrap::Ok:
+                return "Program finished";
+            case eTrap::Halt:
+                return "Program halted";
+            case eTrap::Breakpoint:
+                return "Breakpoint";
+            case eTrap::StackUnderflow:
+                return "Stack is empty";
+            case eTrap::CallStackUnderflow:
+                return "Call stack is empty";
+            case eTrap::UnresolvedLabel:
+                if (operand < 0 && -operand - 1 < LabelType::count()) {
+                    return "Can not find label \"" + LabelType::at(-operand - 1).name() + "\" to jump";
+                }
+                return "Can not find label to jump";
+            case eTrap::DivisionByZero:
+                return "Division by zero";
+            case eTrap::DivisionOverflow:
+                return "Division overflow";
+            case eTrap::StackOverflow:
+                return "Stack overflow";
+            case eTrap::Blocked:
+                return "Blocked on channel " + std::to_string(operand);
+            case eTrap::Disconnected:
+                return "Channel " + std::to_string(operand) + " is not connected";
+            case eTrap::Deadlock:
+                return "Deadlock while waiting on channel " + std::to_string(operand);
+            case eTrap::BadTask:
+                return "Invalid task handle";
+            case eTrap::BadAddress:
+                return "Memory access out of bounds";
+        }
+        return "Unknown trap";
+    }
+};
@@ -0,0 +1,37 @@
+#include <gtest/gtest.h>
+#include <assembler.h>
+#include <prep.h>
+#include "test_data.h"
+
+TEST(Assembler, test_stream) {
+    Assembler assembler;
+    assembler.run("./../../test/data/factor_cycle.txt", "asm_test_build");
+    Preprocessor::clear();
+
+    Preprocessor pre;
+    pre.load("asm_test_build.emu");
+    auto prog = pre.get_program();
+    ASSERT_EQ(prog.size(), assembler.size());
+    int pc = 0;
+    for (auto &statement: factor_cyc) {
+        if (get<0>(statement) != eCommands::Label && get<0>(statement) != eCommands::Blank) {
+            EXPECT_EQ(get<0>(prog[pc++]).name(), get<0>(statement));
+        }
+    }
+    EXPECT_EQ(pre.debug_line(0).line, 2);
+    EXPECT_EQ(pre.debug_line(0).column, 5);
+    EXPECT_EQ(pre.label_name(pre.debug_line(0).label), "factor");
+    EXPECT_EQ(LabelType::get("factor").line(), 0);
+    Preprocessor::clear();
+}
+
+TEST(Assembler, test_unknown_command) {
+    std::ofstream("asm_test_unknown.txt") << "beg\npush 1\npusj 2\nend\n";
+    try {
+        Assembler().run("asm_test_unknown.txt", "asm_test_unknown");
+        FAIL();
+    } catch (InvalidArgumentException &e) {
+        EXPECT_EQ(e.line(), 3);
+    }
+    Preprocessor::clear();
+}
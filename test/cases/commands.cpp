@@ -2,12 +2,12 @@
 #include "commands.h"
 #include "exc.h"
 
-shared_stack stack_ = std::make_shared<CommandStack>();
+auto context_ = Context::create();
 
 TEST(Commands, test_begin) {
     BeginCommand beg = BeginCommand();
     beg.configure("", 15);
-    EXPECT_EQ(beg.run("", 15, stack_), 16);
+    EXPECT_EQ(beg.run("", 15, context_.get()), 16);
     EXPECT_EQ(beg.get_line(), 15);
 
     BeginCommand beg_incorrect = BeginCommand();
@@ -19,7 +19,7 @@ TEST(Commands, test_begin) {
 TEST(Commands, test_end) {
     EndCommand end = EndCommand();
     end.configure("", 14);
-    EXPECT_EQ(end.run("", 14, stack_), -1);
+    EXPECT_EQ(end.run("", 14, context_.get()), -1);
 
     EndCommand end_incorrect = EndCommand();
     EXPECT_THROW(end_incorrect.configure("argument", 4), InvalidArgumentException);
@@ -30,8 +30,8 @@ TEST(Commands, test_end) {
 TEST(Commands, test_push) {
     PushCommand push = PushCommand();
     push.configure("42", 2);
-    EXPECT_EQ(push.run("42", 2, stack_), 3);
-    EXPECT_EQ(stack_->data.top(), 42);
+    EXPECT_EQ(push.run("42", 2, context_.get()), 3);
+    EXPECT_EQ(context_->data.top(), 42);
 
     PushCommand push_incorrect = PushCommand();
     EXPECT_THROW(push_incorrect.configure("ax", 4), std::invalid_argument);
@@ -39,84 +39,89 @@ TEST(Commands, test_push) {
 }
 
 TEST(Commands, test_pop) {
-    uint32_t size = stack_->data.size();
-    stack_->data.push(11);
+    uint32_t size = context_->data.size();
+    context_->data.push(11);
     PopCommand pop = PopCommand();
     pop.configure("", 2);
-    EXPECT_EQ(pop.run("", 2, stack_), 3);
-    EXPECT_EQ(size, stack_->data.size());
+    EXPECT_EQ(pop.run("", 2, context_.get()), 3);
+    EXPECT_EQ(size, context_->data.size());
 
     PopCommand pop_incorrect = PopCommand();
     EXPECT_THROW(pop_incorrect.configure("o", 4), InvalidArgumentException);
 }
 
 TEST(Commands, test_pushr) {
-    RegisterType::get("ax").value() = -777;
+    context_->registers[RegisterType::index("ax")] = -777;
     PushRCommand pushr = PushRCommand();
     pushr.configure("ax", 2);
-    EXPECT_EQ(pushr.run("ax", 2, stack_), 3);
-    EXPECT_EQ(stack_->data.top(), -777);
+    EXPECT_EQ(pushr.run("ax", 2, context_.get()), 3);
+    EXPECT_EQ(context_->data.top(), -777);
 
     PushRCommand pushr_incorrect = PushRCommand();
     EXPECT_THROW(pushr_incorrect.configure("", 4), InvalidArgumentException);
 }
 
 TEST(Commands, test_popr) {
-    uint32_t size = stack_->data.size();
-    stack_->data.push(993);
+    uint32_t size = context_->data.size();
+    context_->data.push(993);
     PopRCommand popr = PopRCommand();
     popr.configure("cx", 2);
-    EXPECT_EQ(popr.run("cx", 2, stack_), 3);
-    EXPECT_EQ(RegisterType::get("cx").value(), 993);
-    EXPECT_EQ(size, stack_->data.size());
+    EXPECT_EQ(popr.run("cx", 2, context_.get()), 3);
+    EXPECT_EQ(context_->registers[RegisterType::index("cx")], 993);
+    EXPECT_EQ(size, context_->data.size());
 
     PopRCommand popr_incorrect = PopRCommand();
     EXPECT_THROW(popr_incorrect.configure("o", 4), InvalidArgumentException);
 }
 
 TEST(Commands, test_add) {
-    stack_->data.push(993);
-    stack_->data.push(7);
+    context_->data.push(993);
+    context_->data.push(7);
     AddCommand add = AddCommand();
     add.configure("", 777);
-    EXPECT_EQ(add.run("", 777, stack_), 778);
-    EXPECT_EQ(1000, stack_->data.top());
+    EXPECT_EQ(add.run("", 777, context_.get()), 778);
+    EXPECT_EQ(1000, context_->data.top());
 
     AddCommand add_incorrect = AddCommand();
     EXPECT_THROW(add_incorrect.configure("38", 4), InvalidArgumentException);
 }
 
 TEST(Commands, test_sub) {
-    stack_->data.push(1000);
-    stack_->data.push(7);
+    context_->data.push(1000);
+    context_->data.push(7);
     SubCommand sub = SubCommand();
     sub.configure("", 0);
-    EXPECT_EQ(sub.run("", 0, stack_), 1);
-    EXPECT_EQ(993, stack_->data.top());
+    EXPECT_EQ(sub.run("", 0, context_.get()), 1);
+    EXPECT_EQ(993, context_->data.top());
 
     SubCommand sub_incorrect = SubCommand();
     EXPECT_THROW(sub_incorrect.configure("string", 4), InvalidArgumentException);
 }
 
 TEST(Commands, test_mul) {
-    stack_->data.push(33);
-    stack_->data.push(-7982);
+    context_->data.push(33);
+    context_->data.push(-7982);
     MulCommand mul = MulCommand();
     mul.configure("", 5);
-    EXPECT_EQ(mul.run("", 5, stack_), 6);
-    EXPECT_EQ(-7982 * 33, stack_->data.top());
+    EXPECT_EQ(mul.run("", 5, context_.get()), 6);
+    EXPECT_EQ(-7982 * 33, context_->data.top());
 
     MulCommand mul_incorrect = MulCommand();
     EXPECT_THROW(mul_incorrect.configure("AHAHAAHAH", 4), InvalidArgumentException);
 }
 
 TEST(Commands, test_div) {
-    stack_->data.push(-11);
-    stack_->data.push(2);
+    context_->data.push(-11);
+    context_->data.push(2);
     DivCommand div = DivCommand();
     div.configure("", 5);
-    EXPECT_EQ(div.run("", 5, stack_), 6);
-    EXPECT_EQ(-5, stack_->data.top());
+    EXPECT_EQ(div.run("", 5, context_.get()), 6);
+    EXPECT_EQ(-5, context_->data.top());
+
+    context_->data.push(0);
+    EXPECT_THROW(div.run("", 5, context_.get()), std::runtime_error);
+    EXPECT_EQ(0, context_->data.top());
+    context_->data.pop();
 
     DivCommand div_incorrect = DivCommand();
     EXPECT_THROW(div_incorrect.configure("100^Pi", 4), InvalidArgumentException);
@@ -134,8 +139,8 @@ TEST(Commands, test_in) {
 
     InCommand in = InCommand();
     in.configure("", 5);
-    EXPECT_EQ(in.run("", 5, stack_), 6);
-    EXPECT_EQ(1524, stack_->data.top());
+    EXPECT_EQ(in.run("", 5, context_.get()), 6);
+    EXPECT_EQ(1524, context_->data.top());
     EXPECT_EQ("Input number: ", s_out.str());
 
     InCommand in_incorrect = InCommand();
@@ -151,14 +156,14 @@ TEST(Commands, test_out) {
     std::cout.rdbuf(s.rdbuf());
 
 
-    stack_->data.push(7777777);
-    stack_->data.push(8888888);
+    context_->data.push(7777777);
+    context_->data.push(8888888);
 
     OutCommand out = OutCommand();
     out.configure("", 5);
-    EXPECT_EQ(out.run("", 5, stack_), 6);
+    EXPECT_EQ(out.run("", 5, context_.get()), 6);
     EXPECT_EQ(s.str(), "8888888\n");
-    EXPECT_EQ(7777777, stack_->data.top());
+    EXPECT_EQ(7777777, context_->data.top());
 
     OutCommand out_incorrect = OutCommand();
     EXPECT_THROW(out_incorrect.configure("eax", 1), InvalidArgumentException);
@@ -169,7 +174,7 @@ TEST(Commands, test_out) {
 TEST(Commands, test_label) {
     LabelCommand label = LabelCommand();
     label.configure("sett0ings", 5);
-    EXPECT_EQ(label.run("sett0ings", 5, stack_), 6);
+    EXPECT_EQ(label.run("sett0ings", 5, context_.get()), 6);
     EXPECT_EQ(LabelType::get("sett0ings").line(), 5);
     EXPECT_EQ(LabelType::get("sett0ings").name(), "sett0ings");
 
@@ -181,194 +186,237 @@ TEST(Commands, test_label) {
 TEST(Commands, test_jump) {
     LabelCommand label = LabelCommand();
     label.configure("target", 5);
-    label.run("target", 5, stack_);
+    label.run("target", 5, context_.get());
 
     JumpCommand jump = JumpCommand();
     jump.configure("target", 15);
-    EXPECT_EQ(jump.run("target", 15, stack_), 5);
+    EXPECT_EQ(jump.run("target", 15, context_.get()), 5);
 
     JumpCommand jump_incorrect = JumpCommand();
     jump_incorrect.configure("target2", 1);
-    EXPECT_THROW(jump_incorrect.run("target2", 1, stack_), InvalidArgumentException);
+    EXPECT_THROW(jump_incorrect.run("target2", 1, context_.get()), InvalidArgumentException);
 }
 
 TEST(Commands, test_jump_equal) {
-    stack_->data.push(11);
-    stack_->data.push(11);
+    context_->data.push(11);
+    context_->data.push(11);
 
     LabelCommand label = LabelCommand();
     label.configure("target", 5);
-    label.run("target", 5, stack_);
+    label.run("target", 5, context_.get());
 
     JumpEqualCommand jump = JumpEqualCommand();
     jump.configure("target", 15);
-    EXPECT_EQ(jump.run("target", 15, stack_), 5);
+    EXPECT_EQ(jump.run("target", 15, context_.get()), 5);
 
-    stack_->data.push(12);
+    context_->data.push(12);
 
-    EXPECT_EQ(jump.run("target", 15, stack_), 16);
+    EXPECT_EQ(jump.run("target", 15, context_.get()), 16);
 
-    stack_->data.pop();
+    context_->data.pop();
 
     JumpEqualCommand jump_incorrect = JumpEqualCommand();
     jump_incorrect.configure("target2", 1);
-    EXPECT_THROW(jump_incorrect.run("target2", 1, stack_), InvalidArgumentException);
+    EXPECT_THROW(jump_incorrect.run("target2", 1, context_.get()), InvalidArgumentException);
 }
 
 TEST(Commands, test_jump_not_equal) {
-    stack_->data.push(11);
-    stack_->data.push(12);
+    context_->data.push(11);
+    context_->data.push(12);
 
     LabelCommand label = LabelCommand();
     label.configure("target", 5);
-    label.run("target", 5, stack_);
+    label.run("target", 5, context_.get());
 
     JumpNotEqualCommand jump = JumpNotEqualCommand();
     jump.configure("target", 15);
-    EXPECT_EQ(jump.run("target", 15, stack_), 5);
+    EXPECT_EQ(jump.run("target", 15, context_.get()), 5);
 
-    stack_->data.push(12);
+    context_->data.push(12);
 
-    EXPECT_EQ(jump.run("target", 15, stack_), 16);
+    EXPECT_EQ(jump.run("target", 15, context_.get()), 16);
 
-    stack_->data.pop();
+    context_->data.pop();
 
     JumpNotEqualCommand jump_incorrect = JumpNotEqualCommand();
     jump_incorrect.configure("target2", 1);
-    EXPECT_THROW(jump_incorrect.run("target2", 1, stack_), InvalidArgumentException);
+    EXPECT_THROW(jump_incorrect.run("target2", 1, context_.get()), InvalidArgumentException);
 }
 
 TEST(Commands, test_jump_greater) {
-    stack_->data.push(11);
-    stack_->data.push(12);
+    context_->data.push(11);
+    context_->data.push(12);
 
     LabelCommand label = LabelCommand();
     label.configure("target", 5);
-    label.run("target", 5, stack_);
+    label.run("target", 5, context_.get());
 
     JumpGreaterCommand jump = JumpGreaterCommand();
     jump.configure("target", 15);
-    EXPECT_EQ(jump.run("target", 15, stack_), 5);
+    EXPECT_EQ(jump.run("target", 15, context_.get()), 5);
 
-    stack_->data.push(12);
+    context_->data.push(12);
 
-    EXPECT_EQ(jump.run("target", 15, stack_), 16);
+    EXPECT_EQ(jump.run("target", 15, context_.get()), 16);
 
-    stack_->data.pop();
+    context_->data.pop();
 
     JumpGreaterCommand jump_incorrect = JumpGreaterCommand();
     jump_incorrect.configure("target2", 1);
-    EXPECT_THROW(jump_incorrect.run("target2", 1, stack_), InvalidArgumentException);
+    EXPECT_THROW(jump_incorrect.run("target2", 1, context_.get()), InvalidArgumentException);
 }
 
 TEST(Commands, test_jump_greater_equal) {
-    stack_->data.push(11);
-    stack_->data.push(12);
+    context_->data.push(11);
+    context_->data.push(12);
 
     LabelCommand label = LabelCommand();
     label.configure("target", 5);
-    label.run("target", 5, stack_);
+    label.run("target", 5, context_.get());
 
     JumpGreaterOrEqualCommand jump = JumpGreaterOrEqualCommand();
     jump.configure("target", 15);
-    EXPECT_EQ(jump.run("target", 15, stack_), 5);
+    EXPECT_EQ(jump.run("target", 15, context_.get()), 5);
 
-    stack_->data.push(12);
+    context_->data.push(12);
 
-    EXPECT_EQ(jump.run("target", 15, stack_), 5);
+    EXPECT_EQ(jump.run("target", 15, context_.get()), 5);
 
-    stack_->data.push(11);
+    context_->data.push(11);
 
-    EXPECT_EQ(jump.run("target", 15, stack_), 16);
+    EXPECT_EQ(jump.run("target", 15, context_.get()), 16);
 
-    stack_->data.pop();
+    context_->data.pop();
 
     JumpGreaterOrEqualCommand jump_incorrect = JumpGreaterOrEqualCommand();
     jump_incorrect.configure("target2", 1);
-    EXPECT_THROW(jump_incorrect.run("target2", 1, stack_), InvalidArgumentException);
+    EXPECT_THROW(jump_incorrect.run("target2", 1, context_.get()), InvalidArgumentException);
 }
 
 TEST(Commands, test_jump_less) {
-    stack_->data.push(12);
-    stack_->data.push(11);
+    context_->data.push(12);
+    context_->data.push(11);
 
     LabelCommand label = LabelCommand();
     label.configure("target", 5);
-    label.run("target", 5, stack_);
+    label.run("target", 5, context_.get());
 
     JumpLessCommand jump = JumpLessCommand();
     jump.configure("target", 15);
-    EXPECT_EQ(jump.run("target", 15, stack_), 5);
+    EXPECT_EQ(jump.run("target", 15, context_.get()), 5);
 
-    stack_->data.push(12);
+    context_->data.push(12);
 
-    EXPECT_EQ(jump.run("target", 15, stack_), 16);
+    EXPECT_EQ(jump.run("target", 15, context_.get()), 16);
 
-    stack_->data.pop();
+    context_->data.pop();
 
     JumpLessCommand jump_incorrect = JumpLessCommand();
     jump_incorrect.configure("target2", 1);
-    EXPECT_THROW(jump_incorrect.run("target2", 1, stack_), InvalidArgumentException);
+    EXPECT_THROW(jump_incorrect.run("target2", 1, context_.get()), InvalidArgumentException);
 }
 
 TEST(Commands, test_jump_less_equal) {
-    stack_->data.push(12);
-    stack_->data.push(11);
+    context_->data.push(12);
+    context_->data.push(11);
 
     LabelCommand label = LabelCommand();
     label.configure("target", 5);
-    label.run("target", 5, stack_);
+    label.run("target", 5, context_.get());
 
     JumpLessOrEqualCommand jump = JumpLessOrEqualCommand();
     jump.configure("target", 15);
-    EXPECT_EQ(jump.run("target", 15, stack_), 5);
+    EXPECT_EQ(jump.run("target", 15, context_.get()), 5);
 
-    stack_->data.push(11);
+    context_->data.push(11);
 
-    EXPECT_EQ(jump.run("target", 15, stack_), 5);
+    EXPECT_EQ(jump.run("target", 15, context_.get()), 5);
 
-    stack_->data.push(12);
+    context_->data.push(12);
 
-    EXPECT_EQ(jump.run("target", 15, stack_), 16);
+    EXPECT_EQ(jump.run("target", 15, context_.get()), 16);
 
-    stack_->data.pop();
+    context_->data.pop();
 
     JumpLessOrEqualCommand jump_incorrect = JumpLessOrEqualCommand();
     jump_incorrect.configure("target2", 1);
-    EXPECT_THROW(jump_incorrect.run("target2", 1, stack_), InvalidArgumentException);
+    EXPECT_THROW(jump_incorrect.run("target2", 1, context_.get()), InvalidArgumentException);
 }
 
 TEST(Commands, test_call) {
     LabelCommand label = LabelCommand();
     label.configure("target", 5);
-    label.run("target", 5, stack_);
+    label.run("target", 5, context_.get());
 
     CallCommand call = CallCommand();
     call.configure("target", 15);
-    EXPECT_EQ(call.run("target", 15, stack_), 5);
-    EXPECT_EQ(stack_->call.top(), 15);
-    stack_->call.pop();
+    EXPECT_EQ(call.run("target", 15, context_.get()), 5);
+    EXPECT_EQ(context_->call.top(), 15);
+    context_->call.pop();
 
     CallCommand jump_incorrect = CallCommand();
     jump_incorrect.configure("target2", 1);
-    EXPECT_THROW(jump_incorrect.run("target2", 1, stack_), InvalidArgumentException);
+    EXPECT_THROW(jump_incorrect.run("target2", 1, context_.get()), InvalidArgumentException);
 }
 
 TEST(Commands, test_ret) {
     LabelCommand label = LabelCommand();
     label.configure("target", 5);
-    label.run("target", 5, stack_);
+    label.run("target", 5, context_.get());
 
     CallCommand call = CallCommand();
     call.configure("target", 15);
-    call.run("target", 15, stack_);
+    call.run("target", 15, context_.get());
 
     RetCommand ret = RetCommand();
     ret.configure("", 5);
-    EXPECT_EQ(ret.run("", 5, stack_), 16);
-    EXPECT_TRUE(stack_->call.empty());
-    EXPECT_THROW(ret.run("target", 5, stack_), std::runtime_error);
+    EXPECT_EQ(ret.run("", 5, context_.get()), 16);
+    EXPECT_TRUE(context_->call.empty());
+    EXPECT_THROW(ret.run("target", 5, context_.get()), std::runtime_error);
 
     RetCommand ret_incorrect = RetCommand();
     EXPECT_THROW(ret_incorrect.configure("target", 1), InvalidArgumentException);
-}
\ No newline at end of file
+}
+TEST(Commands, test_memory) {
+    MemoryCommand memory = MemoryCommand();
+    memory.configure("16", 0);
+    EXPECT_EQ(memory.get_size(), 16);
+    EXPECT_THROW(memory.configure("8", 1), UniqueException);
+    EXPECT_THROW(MemoryCommand().configure("-1", 0), InvalidArgumentException);
+
+    auto context = Context::create({.memory = 16});
+    EXPECT_EQ(context->memory_size, 16);
+    context->data.push(7);
+    context->data.push(100);
+    context->data.push(9);
+    EXPECT_EQ(MemSetCommand().run("", 3, context.get()), 4);
+    EXPECT_EQ(context->memory[6], 0);
+    EXPECT_EQ(context->memory[15], 100);
+    EXPECT_TRUE(context->data.empty());
+
+    context->data.push(5);
+    context->data.push(16);
+    EXPECT_THROW(StoreCommand().run("", 0, context.get()), std::runtime_error);
+    EXPECT_EQ(context->data.size(), 2);
+    context->data.pop();
+    context->data.push(3);
+    EXPECT_EQ(StoreCommand().run("", 0, context.get()), 1);
+
+    context->registers[RegisterType::index("cx")] = 3;
+    EXPECT_EQ(LoadRCommand().run("cx", 0, context.get()), 1);
+    EXPECT_EQ(context->data.top(), 5);
+
+    context->data.push(2);
+    context->data.push(3);
+    context->data.push(5);
+    EXPECT_EQ(MemCpyCommand().run("", 0, context.get()), 1);
+    EXPECT_EQ(context->memory[2], 5);
+    EXPECT_EQ(context->memory[3], 0);
+    EXPECT_EQ(context->memory[6], 100);
+
+    context->data.push(0);
+    context->data.push(16);
+    EXPECT_EQ(MemSumCommand().run("", 0, context.get()), 1);
+    EXPECT_EQ(context->data.top(), 1005);
+    EXPECT_EQ(context->data.size(), 2);
+}
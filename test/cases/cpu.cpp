@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include <allocations.h>
 #include <cpu.h>
 
 TEST(Emulator, test_build) {
@@ -25,4 +26,181 @@ TEST(Emulator, test_run) {
 
     std::cin.rdbuf(in_orig);
     std::cout.rdbuf(out_orig);
-}
\ No newline at end of file
+}
+
+TEST(Emulator, test_trap) {
+    auto err_orig = std::cerr.rdbuf();
+    std::stringstream s_err;
+    std::cerr.rdbuf(s_err.rdbuf());
+
+    CPUEmulator("./../../test/data/div_zero.txt").build("div_zero");
+    CPUEmulator app("div_zero.emu");
+    auto trap = app.run();
+    EXPECT_EQ(trap.kind, eTrap::DivisionByZero);
+    EXPECT_EQ(trap.pc, 3);
+    EXPECT_EQ(trap.data_depth, 2);
+    EXPECT_EQ(trap.call_depth, 0);
+    EXPECT_EQ(s_err.str(), "Error in line 4: Division by zero\n");
+
+    std::cerr.rdbuf(err_orig);
+}
+
+TEST(Emulator, test_underflow) {
+    auto err_orig = std::cerr.rdbuf();
+    std::stringstream s_err;
+    std::cerr.rdbuf(s_err.rdbuf());
+
+    CPUEmulator("./../../test/data/underflow.txt").build("underflow");
+    CPUEmulator app("underflow.emu");
+    auto trap = app.run();
+    EXPECT_EQ(trap.kind, eTrap::StackUnderflow);
+    EXPECT_EQ(trap.pc, 2);
+    EXPECT_EQ(s_err.str(), "Error in line 3: Stack is empty\n");
+
+    std::cerr.rdbuf(err_orig);
+}
+
+TEST(Emulator, test_memo) {
+    auto in_orig = std::cin.rdbuf();
+    auto out_orig = std::cout.rdbuf();
+    auto err_orig = std::cerr.rdbuf();
+    std::stringstream s_out;
+    std::cout.rdbuf(s_out.rdbuf());
+    std::stringstream s_err;
+    std::cerr.rdbuf(s_err.rdbuf());
+    std::stringstream s_in("10");
+    std::cin.rdbuf(s_in.rdbuf());
+
+    CPUEmulator("./../../test/data/factor_memo.txt").build("factor_memo");
+    RunOptions options;
+    options.memo_capacity = 16;
+    CPUEmulator("factor_memo.emu").run(options);
+    EXPECT_EQ(s_out.str(), "Input number: 3628800\n3628800\n");
+    EXPECT_EQ(s_err.str(), "memo: hits=1 misses=1 entries=1\n");
+
+    std::cin.rdbuf(in_orig);
+    std::cout.rdbuf(out_orig);
+    std::cerr.rdbuf(err_orig);
+}
+
+TEST(Emulator, test_spawn) {
+    auto out_orig = std::cout.rdbuf();
+    std::stringstream s_out;
+    std::cout.rdbuf(s_out.rdbuf());
+
+    CPUEmulator("./../../test/data/fib_spawn.txt").build("fib_spawn");
+    for (int workers: {0, 2}) {
+        RunOptions options;
+        options.workers = workers;
+        options.spawn_cutoff = 4;
+        auto trap = CPUEmulator("fib_spawn.emu").run(options);
+        EXPECT_EQ(trap.kind, eTrap::Halt);
+    }
+    EXPECT_EQ(s_out.str(), "6765\n6765\n");
+
+    std::cout.rdbuf(out_orig);
+}
+
+TEST(Emulator, test_allocation_free) {
+    auto in_orig = std::cin.rdbuf();
+    auto out_orig = std::cout.rdbuf();
+    std::ofstream null("/dev/null");
+    std::cout.rdbuf(null.rdbuf());
+
+    for (auto name: {"fibonacci", "fibonacci_1", "factor_cycle", "factor_rec", "factor_memo", "test", "fib_spawn"}) {
+        CPUEmulator(std::string("./../../test/data/") + name + ".txt").build("allocation_free", {.opt_level = 0});
+        std::stringstream s_in("5 5 5 5 5 5 5 5");
+        std::cin.rdbuf(s_in.rdbuf());
+        RunOptions options;
+        options.workers = 0;
+        CPUEmulator app("allocation_free.emu");
+        app.start(options);
+        for (int warmup = 0; warmup < 50 && app.running(); warmup++) {
+            app.step();
+        }
+        auto before = Allocations::count();
+        app.resume();
+        EXPECT_EQ(Allocations::count() - before, 0) << name;
+        CPUEmulator::clear();
+    }
+
+    std::cin.rdbuf(in_orig);
+    std::cout.rdbuf(out_orig);
+}
+
+TEST(Emulator, test_record_replay) {
+    auto in_orig = std::cin.rdbuf();
+    auto out_orig = std::cout.rdbuf();
+    std::stringstream s_out;
+    std::cout.rdbuf(s_out.rdbuf());
+
+    CPUEmulator("./../../test/data/factor_rec.txt").build("record");
+    std::stringstream s_in("6");
+    std::cin.rdbuf(s_in.rdbuf());
+    RunOptions record;
+    record.record_file = "record.journal";
+    CPUEmulator("record.emu").run(record);
+    std::ifstream file("record.journal");
+    std::stringstream journal;
+    journal << file.rdbuf();
+    EXPECT_EQ(journal.str(), "journal 1\ni 0 6\n");
+
+    std::stringstream s_empty;
+    std::cin.rdbuf(s_empty.rdbuf());
+    RunOptions replay;
+    replay.replay_file = "record.journal";
+    CPUEmulator("record.emu").run(replay);
+    EXPECT_EQ(s_out.str(), "Input number: 720\nInput number: 720\n");
+
+    std::cin.rdbuf(in_orig);
+    std::cout.rdbuf(out_orig);
+}
+
+TEST(Emulator, test_cost_model) {
+    CPUEmulator("./../../test/data/cost.txt").build("cost", {.opt_level = 0});
+    RunOptions options;
+    options.cost_model = "./../../test/data/cost.model";
+    options.cost_report = "cost.report";
+    options.profile_file = "cost.profile";
+    auto out_orig = std::cout.rdbuf();
+    std::stringstream s_out;
+    std::cout.rdbuf(s_out.rdbuf());
+    CPUEmulator("cost.emu").run(options);
+    std::cout.rdbuf(out_orig);
+
+    std::ifstream file("cost.report");
+    std::stringstream report;
+    report << file.rdbuf();
+    EXPECT_EQ(s_out.str(), "8\n");
+    EXPECT_NE(report.str().find("cycles: 37 in 18 instructions\n"), std::string::npos);
+    EXPECT_NE(report.str().find("cycles: line 3 6 in 2\n"), std::string::npos);
+    EXPECT_NE(report.str().find("cycles: line 11 6 in 1\n"), std::string::npos);
+    EXPECT_NE(report.str().find("cycles: subroutine main 17 self, 37 total, 1 calls\n"), std::string::npos);
+    EXPECT_NE(report.str().find("cycles: subroutine double 20 self, 20 total, 2 calls\n"), std::string::npos);
+
+    std::ifstream profile_file("cost.profile");
+    std::stringstream profile;
+    profile << profile_file.rdbuf();
+    EXPECT_NE(profile.str().find("11 1 1\n"), std::string::npos);
+}
+
+TEST(Emulator, test_memory) {
+    auto err_orig = std::cerr.rdbuf();
+    auto out_orig = std::cout.rdbuf();
+    std::stringstream s_err;
+    std::cerr.rdbuf(s_err.rdbuf());
+
+    for (BuildOptions options: {BuildOptions{.opt_level = 0}, BuildOptions{.opt_level = 2},
+                                BuildOptions{.stream = true}, BuildOptions{.compress = true}}) {
+        CPUEmulator("./../../test/data/memory.txt").build("memory", options);
+        std::stringstream s_out;
+        std::cout.rdbuf(s_out.rdbuf());
+        auto trap = CPUEmulator("memory.emu").run();
+        std::cout.rdbuf(out_orig);
+        EXPECT_EQ(s_out.str(), "285\n70\n81\n285\n5\n");
+        EXPECT_EQ(trap.kind, eTrap::BadAddress);
+    }
+    EXPECT_NE(s_err.str().find("Error in line 58: Memory access out of bounds\n"), std::string::npos);
+
+    std::cerr.rdbuf(err_orig);
+}
@@ -0,0 +1,30 @@
+#include <gtest/gtest.h>
+#include <debugger.h>
+
+TEST(Debugger, test_breakpoints) {
+    auto in_orig = std::cin.rdbuf();
+    auto out_orig = std::cout.rdbuf();
+
+    std::stringstream s_out;
+    std::cout.rdbuf(s_out.rdbuf());
+    std::stringstream s_in("10");
+    std::cin.rdbuf(s_in.rdbuf());
+
+    std::stringstream commands("b 12\nc\nregs\nstack\ns\nwhere\nd 12\nc\nc\nq\n");
+    std::stringstream output;
+    CPUEmulator app("./../../test/data/factor_rec.txt.emu");
+    Debugger(app, commands, output).run();
+
+    auto text = output.str();
+    EXPECT_NE(text.find("Breakpoint at 12: MUL"), std::string::npos);
+    EXPECT_NE(text.find("Breakpoint hit"), std::string::npos);
+    EXPECT_NE(text.find("cx = 10"), std::string::npos);
+    EXPECT_NE(text.find("[9, 10, 1]"), std::string::npos);
+    EXPECT_NE(text.find("At 13 (line 14): POPR ax"), std::string::npos);
+    EXPECT_NE(text.find("Program finished"), std::string::npos);
+    EXPECT_NE(text.find("Program is not running"), std::string::npos);
+    EXPECT_EQ(s_out.str(), "Input number: 3628800\n");
+
+    std::cin.rdbuf(in_orig);
+    std::cout.rdbuf(out_orig);
+}
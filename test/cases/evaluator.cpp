@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+#include <prep.h>
+
+TEST(Evaluator, test_prefix) {
+    std::vector<Statement> program = {
+            {eCommands::Begin, "",   1},
+            {eCommands::Push,  "6",  2},
+            {eCommands::Push,  "7",  3},
+            {eCommands::Mul,   "",   4},
+            {eCommands::Out,   "",   5},
+            {eCommands::Push,  "5",  6},
+            {eCommands::PopR,  "bx", 7},
+            {eCommands::Push,  "1",  8},
+            {eCommands::In,    "",   9},
+            {eCommands::Add,   "",   10},
+            {eCommands::Out,   "",   11},
+            {eCommands::End,   "",   12}
+    };
+    auto state = PartialEvaluator(100).run(program);
+    Preprocessor::clear();
+    ASSERT_TRUE(state.has_value());
+    EXPECT_EQ(state->output, std::vector<int>({42}));
+    EXPECT_EQ(state->data, std::vector<int>({1}));
+    EXPECT_EQ(state->registers[1], 5);
+    EXPECT_EQ(program[state->entry].command, eCommands::Begin);
+    EXPECT_EQ(program[state->entry + 1].command, eCommands::In);
+    EXPECT_EQ(program.size(), 5);
+
+    auto limited = std::vector<Statement>(program.begin(), program.begin() + 2);
+    EXPECT_FALSE(PartialEvaluator(100).run(limited).has_value());
+    Preprocessor::clear();
+}
+
+TEST(Evaluator, test_collapse) {
+    Preprocessor pre;
+    BuildOptions options;
+    options.opt_level = 2;
+    pre.build("./../../test/data/fibonacci_1.txt", "eval_test_build", options);
+    pre.load("eval_test_build.emu");
+    auto state = pre.get_state();
+    ASSERT_TRUE(state.has_value());
+    EXPECT_EQ(pre.get_program().size(), 2);
+    EXPECT_EQ(state->output.size(), 40);
+    EXPECT_EQ(state->output[0], 1);
+    EXPECT_EQ(state->output[39], 102334155);
+    Preprocessor::clear();
+}
+
+TEST(Evaluator, test_fall_off_end) {
+    std::vector<Statement> program = {
+            {eCommands::Begin, "",  1},
+            {eCommands::Push,  "3", 2},
+            {eCommands::Out,   "",  3}
+    };
+    auto state = PartialEvaluator(100).run(program);
+    Preprocessor::clear();
+    ASSERT_TRUE(state.has_value());
+    EXPECT_EQ(state->output, std::vector<int>({3}));
+    ASSERT_EQ(program.size(), 2);
+    EXPECT_NE(program[1].command, eCommands::End);
+}
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include <launcher.h>
+
+TEST(Channel, test_ring) {
+    Channel channel(3);
+    EXPECT_EQ(channel.capacity(), 4);
+    EXPECT_TRUE(channel.empty());
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(channel.push(i));
+    }
+    EXPECT_TRUE(channel.full());
+    EXPECT_FALSE(channel.push(4));
+    int value;
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(channel.pop(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_FALSE(channel.pop(value));
+}
+
+TEST(Launcher, test_pipeline) {
+    auto out_orig = std::cout.rdbuf();
+    std::stringstream s_out;
+    std::cout.rdbuf(s_out.rdbuf());
+
+    for (auto name: {"pipe_producer", "pipe_square", "pipe_sink"}) {
+        CPUEmulator(std::string("./../../test/data/") + name + ".txt").build(name);
+    }
+    EXPECT_EQ(Launcher("./../../test/data/pipeline.cfg").run(), 0);
+    EXPECT_EQ(s_out.str(), "333833500\n");
+
+    std::cout.rdbuf(out_orig);
+}
+
+TEST(Launcher, test_deadlock) {
+    auto err_orig = std::cerr.rdbuf();
+    std::stringstream s_err;
+    std::cerr.rdbuf(s_err.rdbuf());
+
+    CPUEmulator("./../../test/data/pipe_stuck.txt").build("pipe_stuck");
+    Launcher launcher("./../../test/data/deadlock.cfg");
+    EXPECT_EQ(launcher.run(), 2);
+    EXPECT_EQ(launcher.trap("left").kind, eTrap::Deadlock);
+    EXPECT_EQ(launcher.trap("right").kind, eTrap::Deadlock);
+    EXPECT_NE(s_err.str().find("left: Error in line 2: Deadlock"), std::string::npos);
+
+    std::cerr.rdbuf(err_orig);
+}
+
+TEST(Launcher, test_replay) {
+    auto out_orig = std::cout.rdbuf();
+    std::stringstream s_out;
+    std::cout.rdbuf(s_out.rdbuf());
+
+    CPUEmulator("./../../test/data/echo.txt").build("echo");
+    std::stringstream recorded("journal 2\ni 1 4\no 1 1\ni 0 3\no 0 1\n");
+    auto journal = Journal::read(recorded);
+    ASSERT_TRUE(journal);
+    Launcher launcher("./../../test/data/echo.cfg");
+    EXPECT_EQ(launcher.run(journal.get()), 0);
+    EXPECT_FALSE(journal->diverged());
+    EXPECT_EQ(s_out.str(), "Input number: 40\nInput number: 30\n");
+
+    std::cout.rdbuf(out_orig);
+}
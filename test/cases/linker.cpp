@@ -0,0 +1,36 @@
+#include <gtest/gtest.h>
+#include <cpu.h>
+
+TEST(Linker, test_link) {
+    auto in_orig = std::cin.rdbuf();
+    auto out_orig = std::cout.rdbuf();
+
+    std::stringstream s_out;
+    std::cout.rdbuf(s_out.rdbuf());
+    std::stringstream s_in("12");
+    std::cin.rdbuf(s_in.rdbuf());
+
+    CPUEmulator("./../../test/data/square_lib.txt").build("square_lib", {.module = true, .exports = {"square"}});
+    CPUEmulator("./../../test/data/square_main.txt").build("square_main", {.module = true});
+    CPUEmulator("square").link({"square_main.emu", "square_lib.emu"});
+
+    Parser parser;
+    parser.parse_binary("square_lib.emu");
+    EXPECT_TRUE(parser.module());
+    EXPECT_EQ(parser.get_exports(), std::vector<std::string>{"square"});
+    parser.parse_binary("square_main.emu");
+    EXPECT_EQ(parser.get_imports(), std::vector<std::string>{"square"});
+
+    CPUEmulator app("square.emu");
+    app.run();
+    EXPECT_EQ(s_out.str(), "Input number: 144\n");
+
+    std::cin.rdbuf(in_orig);
+    std::cout.rdbuf(out_orig);
+}
+
+TEST(Linker, test_link_evaluated) {
+    CPUEmulator("./../../test/data/fibonacci_1.txt").build("linker_evaluated", {.opt_level = 2});
+    EXPECT_THROW(Linker().run({"linker_evaluated.emu"}), std::runtime_error);
+    Preprocessor::clear();
+}
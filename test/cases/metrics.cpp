@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include <cpu.h>
+
+TEST(Metrics, test_merge) {
+    Metrics first;
+    first.retired[static_cast<size_t>(eCommands::Push)] = 3;
+    first.peak_data = 7;
+    Metrics second;
+    second.retired[static_cast<size_t>(eCommands::Push)] = 2;
+    second.retired[static_cast<size_t>(eCommands::Out)] = 1;
+    second.peak_data = 4;
+    second.peak_call = 2;
+    first.merge(second);
+    EXPECT_EQ(first.retired[static_cast<size_t>(eCommands::Push)], 5);
+    EXPECT_EQ(first.total_retired(), 6);
+    EXPECT_EQ(first.peak_data, 7);
+    EXPECT_EQ(first.peak_call, 2);
+}
+
+TEST(Metrics, test_export) {
+    auto in_orig = std::cin.rdbuf();
+    auto out_orig = std::cout.rdbuf();
+    std::stringstream s_out;
+    std::cout.rdbuf(s_out.rdbuf());
+    std::stringstream s_in("10");
+    std::cin.rdbuf(s_in.rdbuf());
+
+    MetricsRegistry::reset();
+    RunOptions options;
+    options.metrics_file = "metrics_test.prom";
+    options.metrics_format = eMetricsFormat::Prometheus;
+    CPUEmulator app("./../../test/data/factor_rec.txt.emu");
+    app.run(options);
+    EXPECT_EQ(s_out.str(), "Input number: 3628800\n");
+
+    auto metrics = MetricsRegistry::snapshot();
+    EXPECT_EQ(metrics.retired[static_cast<size_t>(eCommands::Call)], 1);
+    EXPECT_EQ(metrics.retired[static_cast<size_t>(eCommands::Mul)], 10);
+    EXPECT_EQ(metrics.retired[static_cast<size_t>(eCommands::End)], 1);
+    EXPECT_EQ(metrics.peak_call, 1);
+    EXPECT_EQ(metrics.peak_data, 3);
+
+    std::ifstream file("metrics_test.prom");
+    std::stringstream text;
+    text << file.rdbuf();
+    EXPECT_NE(text.str().find("emulator_instructions_retired_total{opcode=\"MUL\"} 10"), std::string::npos);
+    EXPECT_NE(text.str().find("emulator_peak_stack_depth{stack=\"call\"} 1"), std::string::npos);
+    MetricsRegistry::reset();
+
+    std::cin.rdbuf(in_orig);
+    std::cout.rdbuf(out_orig);
+}
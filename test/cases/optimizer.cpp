@@ -0,0 +1,180 @@
+#include <gtest/gtest.h>
+#include <optimizer.h>
+#include <layout.h>
+
+std::vector<Statement> dead_code = {
+        {eCommands::Label, "sub",   1},
+        {eCommands::Push,  "5",     2},
+        {eCommands::PopR,  "bx",    3},
+        {eCommands::Push,  "7",     4},
+        {eCommands::PopR,  "bx",    5},
+        {eCommands::Ret,   "",      6},
+        {eCommands::Label, "unused", 7},
+        {eCommands::Out,   "",      8},
+        {eCommands::Begin, "",      9},
+        {eCommands::Call,  "sub",   10},
+        {eCommands::Jump,  "fin",   11},
+        {eCommands::Push,  "99",    12},
+        {eCommands::Out,   "",      13},
+        {eCommands::Label, "fin",   14},
+        {eCommands::End,   "",      15}
+};
+
+TEST(Graph, test_blocks) {
+    ControlFlowGraph cfg(dead_code);
+    EXPECT_EQ(cfg.blocks().size(), 6);
+    EXPECT_EQ(cfg.entry(), 2);
+    EXPECT_EQ(cfg.label_index("fin"), 13);
+    EXPECT_FALSE(cfg.reachable(7));
+    EXPECT_FALSE(cfg.reachable(11));
+    EXPECT_TRUE(cfg.reachable(1));
+    EXPECT_TRUE(cfg.reachable(14));
+    EXPECT_EQ(cfg.blocks()[cfg.entry()].successors.size(), 2);
+}
+
+TEST(Graph, test_stack_bounds) {
+    auto hints = ControlFlowGraph(dead_code).stack_bounds();
+    EXPECT_EQ(hints.data, 1);
+    EXPECT_EQ(hints.call, 1);
+
+    std::vector<Statement> recursive = {
+            {eCommands::Label, "f", 1},
+            {eCommands::Push,  "1", 2},
+            {eCommands::Call,  "f", 3},
+            {eCommands::Ret,   "",  4},
+            {eCommands::Begin, "",  5},
+            {eCommands::Call,  "f", 6},
+            {eCommands::End,   "",  7}
+    };
+    hints = ControlFlowGraph(recursive).stack_bounds();
+    EXPECT_EQ(hints.data, -1);
+    EXPECT_EQ(hints.call, -1);
+}
+
+TEST(Graph, test_pure_subroutines) {
+    auto pure = ControlFlowGraph(dead_code).pure_subroutines();
+    ASSERT_EQ(pure.size(), 1);
+    EXPECT_EQ(pure[0].entry, 0);
+    EXPECT_EQ(pure[0].pops, 0);
+    EXPECT_EQ(pure[0].pushes, 0);
+    EXPECT_EQ(pure[0].inputs, 0);
+    EXPECT_EQ(pure[0].outputs, 1u << RegisterType::index("bx"));
+}
+
+TEST(Optimizer, test_remove_unreachable) {
+    auto program = dead_code;
+    Optimizer::remove_unreachable(program);
+    std::vector<int> lines;
+    for (auto &statement: program) {
+        lines.push_back(statement.line);
+    }
+    EXPECT_EQ(lines, std::vector<int>({1, 2, 3, 4, 5, 6, 9, 10, 11, 14, 15}));
+}
+
+TEST(Optimizer, test_remove_dead_stores) {
+    auto program = dead_code;
+    Optimizer(1).run(program);
+    std::vector<int> lines;
+    for (auto &statement: program) {
+        lines.push_back(statement.line);
+    }
+    EXPECT_EQ(lines, std::vector<int>({1, 4, 5, 6, 9, 10, 11, 14, 15}));
+
+    Optimizer(0).run(program = dead_code);
+    EXPECT_EQ(program.size(), dead_code.size());
+}
+
+TEST(Optimizer, test_replace_tail_calls) {
+    std::vector<Statement> program = {
+            {eCommands::Label, "sub", 1},
+            {eCommands::Ret,   "",    2},
+            {eCommands::Label, "fwd", 3},
+            {eCommands::Call,  "sub", 4},
+            {eCommands::Blank, "",    5},
+            {eCommands::Ret,   "",    6},
+            {eCommands::Call,  "sub", 7},
+            {eCommands::Out,   "",    8}
+    };
+    Optimizer::replace_tail_calls(program);
+    EXPECT_EQ(program[3].command, eCommands::Jump);
+    EXPECT_EQ(program[6].command, eCommands::Call);
+}
+
+TEST(Optimizer, test_inline_calls) {
+    std::vector<Statement> program = {
+            {eCommands::Label, "loop",  1},
+            {eCommands::Push,  "1",     2},
+            {eCommands::JumpE, "done",  3},
+            {eCommands::Ret,   "",      4},
+            {eCommands::Label, "done",  5},
+            {eCommands::Jump,  "loop",  6},
+            {eCommands::Begin, "",      7},
+            {eCommands::Call,  "loop",  8},
+            {eCommands::Call,  "loop",  9},
+            {eCommands::End,   "",      10}
+    };
+    auto small = program;
+    Optimizer::inline_calls(small, 2);
+    EXPECT_EQ(small.size(), program.size());
+
+    Optimizer(2).run(program);
+    std::set<std::string> labels;
+    for (auto &statement: program) {
+        EXPECT_NE(statement.command, eCommands::Call);
+        EXPECT_NE(statement.command, eCommands::Ret);
+        if (statement.command == eCommands::Label) {
+            EXPECT_TRUE(labels.insert(statement.param).second);
+        }
+    }
+    EXPECT_EQ(labels, std::set<std::string>({"loopinl0", "doneinl0", "loopinl1", "loopinl2", "doneinl1", "loopinl3"}));
+}
+
+TEST(Optimizer, test_inline_fall_off_end) {
+    std::vector<Statement> program = {
+            {eCommands::Begin, "",  1},
+            {eCommands::In,    "",  2},
+            {eCommands::Call,  "f", 3},
+            {eCommands::Push,  "9", 4},
+            {eCommands::Out,   "",  5},
+            {eCommands::End,   "",  6},
+            {eCommands::Label, "f", 7},
+            {eCommands::Out,   "",  8}
+    };
+    Optimizer::inline_calls(program, 16);
+    EXPECT_EQ(program.size(), 8);
+    EXPECT_EQ(program[2].command, eCommands::Call);
+}
+
+TEST(Optimizer, test_layout) {
+    std::vector<Statement> program = {
+            {eCommands::Begin,  "",     1},
+            {eCommands::Label,  "loop", 2},
+            {eCommands::PushR,  "ax",   3},
+            {eCommands::JumpNE, "body", 4},
+            {eCommands::Jump,   "done", 5},
+            {eCommands::Label,  "body", 6},
+            {eCommands::Pop,    "",     7},
+            {eCommands::Jump,   "loop", 8},
+            {eCommands::Label,  "done", 9},
+            {eCommands::End,    "",     10}
+    };
+    std::stringstream profile("1 1 0\n3 11 0\n4 11 10\n5 1 1\n7 10 0\n8 10 10\n10 1 0\n");
+    Layout(Layout::read(profile)).run(program);
+    std::vector<std::pair<eCommands, std::string>> expected = {
+            {eCommands::Begin, ""},
+            {eCommands::Label, "loop"},
+            {eCommands::PushR, "ax"},
+            {eCommands::JumpE, "pgo0"},
+            {eCommands::Label, "body"},
+            {eCommands::Pop,   ""},
+            {eCommands::Jump,  "loop"},
+            {eCommands::Label, "pgo0"},
+            {eCommands::Label, "done"},
+            {eCommands::End,   ""}
+    };
+    ASSERT_EQ(program.size(), expected.size());
+    for (int i = 0; i < program.size(); i++) {
+        EXPECT_EQ(program[i].command, expected[i].first);
+        EXPECT_EQ(program[i].param, expected[i].second);
+    }
+}
@@ -0,0 +1,31 @@
+#include <gtest/gtest.h>
+#include <cpu.h>
+
+TEST(Perf, test_run) {
+    auto in_orig = std::cin.rdbuf();
+    auto out_orig = std::cout.rdbuf();
+    auto err_orig = std::cerr.rdbuf();
+    std::stringstream s_out;
+    std::cout.rdbuf(s_out.rdbuf());
+    std::stringstream s_err;
+    std::cerr.rdbuf(s_err.rdbuf());
+    std::stringstream s_in("10");
+    std::cin.rdbuf(s_in.rdbuf());
+
+    RunOptions options;
+    options.perf_counters = true;
+    options.perf_sample_period = 1;
+    CPUEmulator app("./../../test/data/factor_rec.txt.emu");
+    app.run(options);
+    EXPECT_EQ(s_out.str(), "Input number: 3628800\n");
+    if (PerfCounters().available()) {
+        EXPECT_NE(s_err.str().find("perf: phase load:"), std::string::npos);
+        EXPECT_NE(s_err.str().find("perf: opcode MUL (10 samples):"), std::string::npos);
+    } else {
+        EXPECT_NE(s_err.str().find("perf: hardware counters are unavailable"), std::string::npos);
+    }
+
+    std::cin.rdbuf(in_orig);
+    std::cout.rdbuf(out_orig);
+    std::cerr.rdbuf(err_orig);
+}
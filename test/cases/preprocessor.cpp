@@ -1,3 +1,4 @@
+#include <filesystem>
 #include <gtest/gtest.h>
 #include <prep.h>
 #include "test_data.h"
@@ -13,8 +14,97 @@ TEST(Preprocessor, test_load) {
     Preprocessor pre;
     pre.load("prep_test_build.emu");
     auto prog = pre.get_program();
+    std::vector<eCommands> expected;
+    for (auto &statement: factor_cyc) {
+        if (get<0>(statement) != eCommands::Label && get<0>(statement) != eCommands::Blank) {
+            expected.push_back(get<0>(statement));
+        }
+    }
+    ASSERT_EQ(prog.size(), expected.size());
     for (int i = 0; i < prog.size(); i++) {
-        EXPECT_EQ(get<0>(prog[i]).name(), get<0>(factor_cyc[i]));
+        EXPECT_EQ(get<0>(prog[i]).name(), expected[i]);
+    }
+    EXPECT_EQ(pre.debug_line(0).line, 2);
+    EXPECT_EQ(pre.debug_line(0).column, 5);
+    Preprocessor::clear();
+}
+
+TEST(Preprocessor, test_strip) {
+    Preprocessor pre;
+    pre.build("./../../test/data/factor_cycle.txt", "prep_test_strip", {.strip = true});
+    Preprocessor::clear();
+    pre.load("prep_test_strip.emu");
+    EXPECT_EQ(pre.debug_line(0).line, -1);
+    EXPECT_NE(LabelType::get("start").line(), -1);
+    Preprocessor::clear();
+}
+
+TEST(Preprocessor, test_decode) {
+    Preprocessor pre;
+    pre.load("./../../test/data/factor_rec.txt.emu");
+    auto &decoded = pre.get_decoded();
+    auto prog = pre.get_program();
+    ASSERT_EQ(decoded.size(), prog.size());
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(decoded.data()) % 64, 0);
+    for (int i = 0; i < decoded.size(); i++) {
+        EXPECT_EQ(decoded[i].command, get<0>(factor_rec[i]));
+    }
+    EXPECT_EQ(decoded[1].operand, RegisterType::index("cx"));
+    EXPECT_EQ(decoded[3].operand, 1);
+    EXPECT_EQ(decoded[7].operand, 17);
+    EXPECT_EQ(decoded[26].operand, 0);
+    Preprocessor::clear();
+}
+
+TEST(Preprocessor, test_compress) {
+    Preprocessor plain;
+    plain.build("./../../test/data/factor_rec.txt", "prep_test_plain");
+    Preprocessor::clear();
+    Preprocessor packed;
+    packed.build("./../../test/data/factor_rec.txt", "prep_test_packed", {.compress = true});
+    Preprocessor::clear();
+
+    EXPECT_LT(std::filesystem::file_size("prep_test_packed.emu"), std::filesystem::file_size("prep_test_plain.emu"));
+    std::ifstream file("prep_test_packed.emu", std::ios::binary);
+    std::string magic(compressed_magic.size(), '\0');
+    file.read(magic.data(), static_cast<std::streamsize>(magic.size()));
+    EXPECT_EQ(magic, compressed_magic);
+
+    plain.load("prep_test_plain.emu");
+    auto expected = plain.get_decoded();
+    auto line = plain.debug_line(5);
+    Preprocessor::clear();
+    packed.load("prep_test_packed.emu");
+    auto &decoded = packed.get_decoded();
+    ASSERT_EQ(decoded.size(), expected.size());
+    for (int i = 0; i < decoded.size(); i++) {
+        EXPECT_EQ(decoded[i].command, expected[i].command);
+        EXPECT_EQ(decoded[i].operand, expected[i].operand);
     }
+    EXPECT_EQ(packed.debug_line(5).line, line.line);
+    EXPECT_EQ(packed.debug_line(5).label, line.label);
     Preprocessor::clear();
-}
\ No newline at end of file
+}
+
+TEST(Preprocessor, test_emit_c) {
+    Preprocessor().build("./../../test/data/div_zero.txt", "prep_test_c", {.emit_c = true});
+    Preprocessor::clear();
+
+    std::ifstream file("prep_test_c.c");
+    ASSERT_TRUE(file.is_open());
+    std::stringstream source;
+    source << file.rdbuf();
+    EXPECT_NE(source.str().find("int main(void)"), std::string::npos);
+    EXPECT_NE(source.str().find("TRAP(4, \"Division by zero\")"), std::string::npos);
+}
+
+TEST(Preprocessor, test_native_keeps_source) {
+    std::filesystem::copy_file("./../../test/data/div_zero.txt", "prep_native.txt",
+                               std::filesystem::copy_options::overwrite_existing);
+    EXPECT_EXIT(Preprocessor().build("prep_native.txt", "prep_native.txt", {.emit_c = true, .native = true}),
+                testing::ExitedWithCode(1), "would overwrite the source file");
+    std::ifstream file("prep_native.txt");
+    std::string first;
+    std::getline(file, first);
+    EXPECT_EQ(first, "beg");
+}
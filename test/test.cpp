@@ -4,4 +4,20 @@
 
 #include "cases/preprocessor.cpp"
 
-#include "cases/cpu.cpp"
\ No newline at end of file
+#include "cases/assembler.cpp"
+
+#include "cases/linker.cpp"
+
+#include "cases/cpu.cpp"
+
+#include "cases/optimizer.cpp"
+
+#include "cases/evaluator.cpp"
+
+#include "cases/debugger.cpp"
+
+#include "cases/metrics.cpp"
+
+#include "cases/perf.cpp"
+
+#include "cases/launcher.cpp"